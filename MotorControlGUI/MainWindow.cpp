@@ -21,207 +21,106 @@
 MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent)
     , ui(new Ui::MainWindow)
-    , m_p_main_loop_timer(new QTimer(this))     //creating "Main Loop" timer object
+    , m_p_display_timer(new QTimer(this))       //creating the display timer object
+    , m_p_node_table(new NodeTableModel(&m_telemetry, this))
+    , m_p_worker(new SerialWorker(&m_telemetry, &m_samples))
 {
     ui->setupUi(this);
+    ui->tableViewNodes->setModel(m_p_node_table);
 
-    //initializing the "Main Loop" timer
-    connect(m_p_main_loop_timer, &QTimer::timeout, this, &MainWindow::main_loop);
-    //m_p_main_loop_timer->setTimerType(Qt::PreciseTimer);
-    m_p_main_loop_timer->setTimerType(Qt::CoarseTimer);
-    //This timer's period defines how often commands are going to be sent to the controller,
-    //...and how often telemetry messages are read out.
-    //Do not send commands to the contoller too often, as the controller's CPU might be overloaded by the incoming USB traffic.
-    m_p_main_loop_timer->start(100);    //ms;
+    //resetting the runtime state parameters
+    m_node_id = 1;
+    m_is_sending_ongoing = false;
+    m_is_port_open = false;
+    m_displayed_sequence = 0;
+
+    //moving the serial port, the SLCAN decoding and the sending of commands to the I/O thread...
+    //...the signals below cross the thread boundary as queued calls, so the GUI thread never waits for the serial port.
+    m_p_worker->moveToThread(&m_io_thread);
+    connect(&m_io_thread, &QThread::finished, m_p_worker, &QObject::deleteLater);
+    connect(this, &MainWindow::open_port_requested,     m_p_worker, &SerialWorker::open_port);
+    connect(this, &MainWindow::close_port_requested,    m_p_worker, &SerialWorker::close_port);
+    connect(this, &MainWindow::start_sending_requested, m_p_worker, &SerialWorker::start_sending);
+    connect(this, &MainWindow::speed_target_changed,    m_p_worker, &SerialWorker::set_speed_target);
+    connect(this, &MainWindow::stop_sending_requested,  m_p_worker, &SerialWorker::stop_sending);
+    connect(this, &MainWindow::reset_requested,         m_p_worker, &SerialWorker::send_reset);
+    connect(m_p_worker, &SerialWorker::port_opened, this, &MainWindow::handle_port_opened);
+    m_io_thread.start();
+
+    //initializing the display timer...
+    //...the telemetry may arrive at kHz rates; the GUI shows only the latest state at a rate the eye can follow.
+    connect(m_p_display_timer, &QTimer::timeout, this, &MainWindow::display_telemetry);
+    m_p_display_timer->setTimerType(Qt::CoarseTimer);
+    m_p_display_timer->start(50);       //ms, 20 frames per second
 
     //populating a list of serial ports
     on_pushButtonRefresh_clicked();
 
     //enable or disable GUI controls
     manage_gui();
-
-    //resetting the runtime state parameters
-    m_node_id = 1;
-    m_is_sending_ongoing = false;
 }
 
 MainWindow::~MainWindow()
 {
+    //stopping the I/O thread before m_telemetry goes away; the worker closes the serial port as it is deleted
+    m_io_thread.quit();
+    m_io_thread.wait();
     delete ui;
 }
 
 //This function is periodically called using QT Timer mechanism.
-//  The function serves the purpose of the "Main Loop" of a typical control system.
-void MainWindow::main_loop()
+//  The function feeds the plots and copies the latest telemetry of the controller from the telemetry store, if there is anything new.
+void MainWindow::display_telemetry()
 {
-    if(m_serial_port.isOpen())
+    if(!m_is_port_open)
     {
-        ///////////////////////////////////////////////////////////////////////////////////////////////////////
-        /// Step 1: Reading out Telemetry
-        ///////////////////////////////////////////////////////////////////////////////////////////////////////
-        char symbol = 0;
-        //Reading out all available symbols one by one from the virtual serial port
-        while(true)
-        {
-            //reading out a single symbol if it is available
-            const ssize_t nread = m_serial_port.read(&symbol, sizeof(symbol));
-            if (nread > 0)
-            {
-                //feeding the symbol to the SLCAN decoder object
-                //... the method returns true if a complete SLCAN message has been received
-                const bool is_message_received = m_decoder.process_symbol(symbol);
-
-                if(is_message_received) //a complete SLCAN message has been received
-                {
-                    //extracting CAN ID from the decoder object
-                    const uint32_t CAN_ID  = m_decoder.get_can_id();
-                    //using helper functions to split CAN ID into NODE ID and COB ID
-                    const uint32_t NODE_ID = servosila::extract_node_id_from_can_id(CAN_ID);    //this ID tells what of the controllers on CAN network sent the telemetry message
-                    const uint32_t COB_ID  = servosila::extract_cob_id_from_can_id (CAN_ID);    //this ID tells how to decode the message (format). Refer to Servosila Device Reference document for telemetry message formats by their COB IDs.
-
-                    //applying different decoding logic (format) depending on what telemetry message has been received
-                    switch(COB_ID)
-                    {
-                        case 0x180:
-                        {
-                            //decoding Fault Bits (UINT16, position in Payload: 0)
-                            uint16_t fault_bits = 0;
-                            memcpy(&fault_bits, &(m_decoder.get_payload()[0]), sizeof(fault_bits));   //extracting INT16
-
-                            //decoding Udc voltage (FLOAT16, position in Payload: 2)
-                            int16_t Udc_float16 = 0;    //ATTENTION: FLOAT16 is transmitted as INT16
-                            memcpy(&Udc_float16, &(m_decoder.get_payload()[2]), sizeof(Udc_float16));
-                            const float Udc = servosila::decode_float16(Udc_float16);   //converting INT16->FLOAT32
-
-                            //decoding Speed in Hz, electrical (FLOAT32, position in Payload: 4)
-                            float SPEED = 0.0;
-                            memcpy(&SPEED, &(m_decoder.get_payload()[4]), sizeof(SPEED)); //extracting FLOAT32
-
-                            //filtering out telemetry related to the Node ID of interest
-                            if(NODE_ID == m_node_id)    //remove this line if you want to receive telemetry from all controllers on CAN network
-                            {
-                                process_telemetry(fault_bits, Udc, SPEED);  //calling an application-specific routine to display telemetry once the telemetry message has been decoded
-                            }
-
-                            break;
-                        }
-                        case 0x280:
-                        case 0x380:
-                        case 0x480:
-                        {
-                            //TODO: Add other telemetry handlers here
-                            //...the formats are defined in Servosila Device Reference document for your device.
-                            //The processing principle is the same as for the 0x180 telemetry message.
-                            break;
-                        }
-                    }
-                }
-            }
-            else
-            {   //no symbols left to be read out from the virtual serial port
-                //...just breaking from the loop to work on something else
-                break;
-            }
-        } //while() for reading out symbols
-
-        ///////////////////////////////////////////////////////////////////////////////////////////////////////
-        /// Step 2: Sending out commands (periodically)
-        ///////////////////////////////////////////////////////////////////////////////////////////////////////
-
-        if(m_is_sending_ongoing)    //this flag is enabled or disabled by the "Start/Stop" button or by "Reset" button
-        {
-            //reading out speed target from the GUI
-            const float speed_target = ui->doubleSpinBoxSpeed->value();
+        //the I/O thread may have queued samples before it closed the port; they must not show up after a reconnect
+        discard_samples();
+        return;
+    }
 
-            //calling a procedure that encodes and sends out an Electronic Speed Control command
-            send_speed_command(speed_target);
+    //moving all samples queued since the previous refresh into the plot's history; the plot is redrawn once per refresh
+    telemetry_sample samples[256];
+    size_t nsamples = 0;
+    while((nsamples = m_samples.pop_many(samples, 256)) > 0)
+    {
+        for(size_t i=0; i<nsamples; i++)
+        {
+            const telemetry_sample& sample = samples[i];
+            ui->plotWidget->add_sample(sample.node_id, sample.timestamp_ns, sample.fault_bits, sample.Udc, sample.speed);
         }
     }
-}
+    ui->plotWidget->update();
 
-//a helper function that send out a Electronic Speed Control command
-void MainWindow::send_speed_command(float speed_target)
-{
-    const uint32_t COB_ID       = 0x200;    //this value comes from Servosila Device Reference document, section related to "Electronic Speed Control" command
-    const uint8_t  COMMAND_CODE = 0x20;     //this value comes from Servosila Device Reference document, section related to "Electronic Speed Control" command
-
-    //an SLCAN message buffer: an array of chars
-    char message[27];
-    //a CAN Payload array (8bytes)
-    uint8_t payload[8];
-
-    //zero out all 8 bytes in the payload before filling out with new data
-    memset(&payload, 0, sizeof(payload));
-
-    //setting Command Code in Payload
-    payload[0] = COMMAND_CODE;          //the very first byte in payload of a command message is the command code.
+    //the dashboard picks up new controllers and repaints only the cells that have changed
+    m_p_node_table->refresh();
 
-    //setting Speed parameter in Payload
-    // That the parameter is a FLOAT32 with position 4 comes from Servosila Device Reference document, section related to "Electronic Speed Control" command.
-    memcpy(&(payload[4]), &(speed_target), sizeof(speed_target));
+    //a cheap check whether the I/O thread has received anything from the controlled node since the previous refresh
+    const uint32_t sequence = m_telemetry.get_sequence(m_node_id);
+    if(sequence == m_displayed_sequence) return;
 
-    //encoding an SLCAN text message
-    //...the routine is implemented in slcan-encoder.h
-    //...the inputs are Node ID, COB ID, and Payload.
-    const size_t message_size = servosila::slcan_encode_11bit(m_node_id+COB_ID, payload, 8, message);
+    servosila::node_snapshot snapshot;
+    m_telemetry.read(m_node_id, snapshot);
+    m_displayed_sequence = snapshot.sequence;
 
-    //writing the SLCAN text message to the virtual serial port
-    m_serial_port.write(&(message[0]), message_size);
-}
-
-//a helper function that send out a STOP command
-void MainWindow::send_stop_command()
-{
-    const uint32_t COB_ID       = 0x200;    //this value comes from Servosila Device Reference document
-    const uint8_t  COMMAND_CODE = 0x04;     //this value comes from Servosila Device Reference document
-
-    //an SLCAN message buffer: an array of chars
-    char message[27];
-    //a CAN Payload array (8bytes)
-    uint8_t payload[8];
-
-    //zero out all 8 bytes in the payload before filling out with new data
-    memset(&payload, 0, sizeof(payload));
-
-    //setting Command Code in Payload
-    payload[0] = COMMAND_CODE;          //the very first byte in payload of a command message is the command code.
-
-    //encoding an SLCAN text message
-    //...the routine is implemented in slcan-encoder.h
-    //...the inputs are Node ID, COB ID, and Payload.
-    const size_t message_size = servosila::slcan_encode_11bit(m_node_id+COB_ID, payload, 8, message);
-
-    //writing the SLCAN text message to the virtual serial port
-    m_serial_port.write(&(message[0]), message_size);
+    if(snapshot.received & 0x1)     //0x180 has been received
+    {
+        const servosila::telemetry_180& pdo_180 = snapshot.telemetry.pdo_180;
+        process_telemetry(pdo_180.fault_bits, pdo_180.Udc, pdo_180.speed);  //calling an application-specific routine to display telemetry
+    }
+    //the channels of 0x280, 0x380 and 0x480 are in snapshot.telemetry.pdo_280, pdo_380 and pdo_480...
+    //...the formats are defined in Servosila Device Reference document for your device.
+    //TODO: Add other telemetry handlers here
 }
 
-//a helper function that send out a RESET command
-void MainWindow::send_reset_command()
+//empties the queue of samples for the plots without plotting them
+void MainWindow::discard_samples()
 {
-    const uint32_t COB_ID       = 0x200;    //this value comes from Servosila Device Reference document
-    const uint8_t  COMMAND_CODE = 0x01;     //this value comes from Servosila Device Reference document
-
-    //an SLCAN message buffer: an array of chars
-    char message[27];
-    //a CAN Payload array (8bytes)
-    uint8_t payload[8];
-
-    //zero out all 8 bytes in the payload before filling out with new data
-    memset(&payload, 0, sizeof(payload));
-
-    //setting Command Code in Payload
-    payload[0] = COMMAND_CODE;          //the very first byte in payload of a command message is the command code.
-
-    //encoding an SLCAN text message
-    //...the routine is implemented in slcan-encoder.h
-    //...the inputs are Node ID, COB ID, and Payload.
-    const size_t message_size = servosila::slcan_encode_11bit(m_node_id+COB_ID, payload, 8, message);
-
-    //writing the SLCAN text message to the virtual serial port
-    m_serial_port.write(&(message[0]), message_size);
+    telemetry_sample samples[256];
+    while(m_samples.pop_many(samples, 256) > 0) {}
 }
 
-//This routine is called from the main_loop() whenever a telemetry message is received
+//This routine is called from the display_telemetry() whenever new telemetry has been received
 //  The routine just displays the telemetry on the GUI.
 void MainWindow::process_telemetry(uint16_t fault_bits, float Udc, float speed)
 {
@@ -236,7 +135,7 @@ void MainWindow::process_telemetry(uint16_t fault_bits, float Udc, float speed)
 void MainWindow::manage_gui()
 {
     //a simple GUI state machine
-    if(m_serial_port.isOpen())
+    if(m_is_port_open)
     {
         ui->pushButtonConnect->setText(tr("Disconnect"));
         ui->pushButtonRefresh->setEnabled(false);
@@ -285,30 +184,45 @@ void MainWindow::on_pushButtonConnect_clicked()
     //updating Node ID of the device we are going to control
     m_node_id = ui->spinBoxNodeID->value();
 
-    //connecting to or disconnecting from the serial port
-    if(!m_serial_port.isOpen())
+    //connecting to a selected serial port...
+    //...the I/O thread opens the serial port and reports back with handle_port_opened().
+    if(!m_is_port_open)
     {
         const QString serial_port_name = ui->comboBoxSerialPorts->currentText();
-
-        //connecting to a selected serial port
-        m_serial_port.setPortName(serial_port_name);
-        const bool result = m_serial_port.open(QIODevice::ReadWrite);
-        if(!result)
-        {
-            QMessageBox::information(this, tr("Serial Port"), tr("Cannot open the serial port."), QMessageBox::Ok);
-        }
+        ui->pushButtonConnect->setEnabled(false);   //until the I/O thread reports back
+        emit open_port_requested(serial_port_name, m_node_id);
+        return;
     }
-    else
+
+    //disconnecting from the serial port
+    emit close_port_requested();
+    m_is_port_open = false;
+    m_is_sending_ongoing = false;
+
+    //enable or disable GUI controls
+    manage_gui();
+}
+
+//This routine is called when the I/O thread has tried to open the serial port
+void MainWindow::handle_port_opened(bool is_opened)
+{
+    ui->pushButtonConnect->setEnabled(true);
+    m_is_port_open = is_opened;
+    m_displayed_sequence = m_telemetry.get_sequence(m_node_id);     //showing only the telemetry received from now on
+    m_p_node_table->clear();                                        //the controllers are discovered anew
+    discard_samples();                                              //the samples of the previous connection are dropped
+    ui->plotWidget->clear();
+    ui->plotWidget->set_node_id(m_node_id);
+    if(!is_opened)
     {
-        m_serial_port.close();
-        m_is_sending_ongoing = false;
+        QMessageBox::information(this, tr("Serial Port"), tr("Cannot open the serial port."), QMessageBox::Ok);
     }
 
     //enable or disable GUI controls
     manage_gui();
 }
 
-//this routine raises or clears a flag (m_is_sending_ongoing) that controls whether or not the main loop periodically sends commands to the contoller
+//this routine raises or clears a flag (m_is_sending_ongoing) that controls whether or not the I/O thread periodically sends commands to the contoller
 //In addition, this routine sends our a STOP command to the controller (once) when needed.
 void MainWindow::on_pushButtonStart_clicked()
 {
@@ -317,16 +231,32 @@ void MainWindow::on_pushButtonStart_clicked()
         ui->pushButtonStart->setText("Start");
         m_is_sending_ongoing = false;
 
-        //calling a procedure that sends out a STOP command to the controller
-        send_stop_command();
+        //stopping periodic sending; the I/O thread sends out a STOP command to the controller
+        emit stop_sending_requested();
     }
     else
     {
         ui->pushButtonStart->setText("Stop");
         m_is_sending_ongoing = true;
+
+        //the I/O thread sends the ESC command periodically from now on
+        emit start_sending_requested(ui->doubleSpinBoxSpeed->value());
     }
 }
 
+//the speed target is passed to the I/O thread as soon as it changes, rather than polled
+void MainWindow::on_doubleSpinBoxSpeed_valueChanged(double value)
+{
+    if(m_is_sending_ongoing) emit speed_target_changed(static_cast<float>(value));
+}
+
+//the plots show the controller picked on the dashboard
+void MainWindow::on_tableViewNodes_clicked(const QModelIndex &index)
+{
+    const uint32_t node_id = m_p_node_table->get_node_id(index.row());
+    if(node_id != 0) ui->plotWidget->set_node_id(node_id);
+}
+
 /*
 The RESET command clears "Fault Bits" latches, powers off the motor, resets the inverter circuitry, and resets the Work Zone
 position. Use this command to clear fault flags whenever Fault Bits telemetry indicates a fault, to reset servo position
@@ -336,8 +266,8 @@ waiting for a "Reset" command to come from a parent control system.
 */
 void MainWindow::on_pushButtonReset_clicked()
 {
-    //sending out a RESET command to the controller
-    send_reset_command();
+    //sending out a RESET command to the controller; this also stops periodic sending of the ESC command
+    emit reset_requested();
 
     //stopping periodic sending of the ESC command
     ui->pushButtonStart->setText(tr("Start"));
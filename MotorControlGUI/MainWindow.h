@@ -16,13 +16,13 @@
 #ifndef MAINWINDOW_H
 #define MAINWINDOW_H
 
-#include "../servosila-common/slcan-encoder.h"
-#include "../servosila-common/slcan-decoder.h"
-#include "../servosila-common/canopen-decoder.h"
+#include "../servosila-common/telemetry-store.h"
+#include "SerialWorker.h"
+#include "NodeTableModel.h"
 
 #include <QMainWindow>
-#include <QTimer>           //periodic ("Main Loop") timer
-#include <QSerialPort>      //creoss-platform Serial Port API encapsulation
+#include <QTimer>           //periodic display timer
+#include <QThread>          //I/O thread
 
 QT_BEGIN_NAMESPACE
 namespace Ui { class MainWindow; }
@@ -36,20 +36,42 @@ public:
     MainWindow(QWidget *parent = nullptr);
     ~MainWindow();
 
+signals:
+    //requests to the serial worker in the I/O thread
+    void open_port_requested(const QString& port_name, uint32_t node_id);
+    void close_port_requested();
+    void start_sending_requested(float speed_target);
+    void speed_target_changed(float speed_target);
+    void stop_sending_requested();
+    void reset_requested();
+
 private slots:
     void on_pushButtonRefresh_clicked();
     void on_pushButtonConnect_clicked();
     void on_pushButtonStart_clicked();
     void on_pushButtonReset_clicked();
+    void on_doubleSpinBoxSpeed_valueChanged(double value);
+    void on_tableViewNodes_clicked(const QModelIndex &index);
+    void handle_port_opened(bool is_opened);
 
 private:
     Ui::MainWindow *ui;
-    //periodic timer ("Main Loop")
-    QTimer* m_p_main_loop_timer;
-    //cross-platform Serial Port object
-    QSerialPort m_serial_port;
-    //SLCAN decoder object
-    servosila::slcan_decoder m_decoder;
+    //periodic timer that refreshes the telemetry on the GUI
+    QTimer* m_p_display_timer;
+    //the latest telemetry of every controller; written by the I/O thread, read by the GUI thread
+    servosila::telemetry_store m_telemetry;
+    //every 0x180 telemetry message for the plots; pushed by the I/O thread, popped by the GUI thread
+    servosila::spsc_queue<telemetry_sample> m_samples;
+    //the dashboard of all controllers heard on CAN network
+    NodeTableModel* m_p_node_table;
+    //the thread that runs the serial port, the SLCAN decoder and the command scheduler
+    QThread m_io_thread;
+    //the serial worker object; lives in m_io_thread, deleted when the thread finishes
+    SerialWorker* m_p_worker;
+    //the serial port is open
+    bool m_is_port_open;
+    //the telemetry sequence number of the controller shown on the GUI
+    uint32_t m_displayed_sequence;
     //A flag that tells that the user has initiated periodical sending of the command to the controller. The flag is updated by Start/Stop button.
     bool m_is_sending_ongoing;
     //Node ID of the controller. This attribute is updated from the GUI.
@@ -57,10 +79,8 @@ private:
 
 private:
     void manage_gui();
-    void main_loop();
+    void display_telemetry();
+    void discard_samples();
     void process_telemetry(uint16_t fault_bits, float Udc, float speed);
-    void send_speed_command(float speed_target);
-    void send_stop_command();
-    void send_reset_command();
 };
 #endif // MAINWINDOW_H
@@ -11,13 +11,31 @@ CONFIG += c++11
 
 SOURCES += \
     main.cpp \
-    MainWindow.cpp
+    MainWindow.cpp \
+    NodeTableModel.cpp \
+    PlotWidget.cpp \
+    SerialWorker.cpp
 
 HEADERS += \
     ../servosila-common/canopen-decoder.h \
-    ../servosila-common/slcan-decoder.h \
-    ../servosila-common/slcan-encoder.h \
-    MainWindow.h
+    ../servosila-common/can-id-filter.h \
+    ../servosila-common/can-message.h \
+    ../servosila-common/command-scheduler.h \
+    ../servosila-common/commands.h \
+    ../servosila-common/hex-codec.h \
+    ../servosila-common/slcan-buffer-decoder.h \
+    ../servosila-common/float16-batch.h \
+    ../servosila-common/min-max-history.h \
+    ../servosila-common/monotonic-clock.h \
+    ../servosila-common/telemetry-decoder.h \
+    ../servosila-common/telemetry-store.h \
+    ../servosila-common/slcan-message-encoder.h \
+    ../servosila-common/slcan-command-builder.h \
+    ../servosila-common/spsc-queue.h \
+    MainWindow.h \
+    NodeTableModel.h \
+    PlotWidget.h \
+    SerialWorker.h
 
 FORMS += \
     MainWindow.ui
@@ -0,0 +1,172 @@
+/////////////////////////////////////////////////////////////////////////////
+//
+//  This sample source code comes with Servosila SC-25C Brushless Motor Controllers.
+//      OS: Windows or Linux
+//      Interface to SC-25: SLCAN via USB virtual serial port
+//
+//  The code is provided "AS IS" without any kind of guarantees or warranties.
+//  Use it at your own risk.
+//
+//  The code is free for everyone to use, modify or redistribute.
+//
+//  www.servosila.com
+//
+/////////////////////////////////////////////////////////////////////////////
+
+#include "NodeTableModel.h"
+#include <QBrush>
+#include <math.h>       //fabsf()
+
+NodeTableModel::NodeTableModel(const servosila::telemetry_store* p_telemetry, QObject *parent)
+    : QAbstractTableModel(parent)
+    , m_p_telemetry(p_telemetry)
+{
+    m_rows.reserve(MAX_NODE_ID);
+    for(uint32_t node_id=0; node_id<=MAX_NODE_ID; node_id++) m_row_of_node[node_id] = -1;
+}
+
+void NodeTableModel::refresh()
+{
+    for(uint32_t node_id=1; node_id<=MAX_NODE_ID; node_id++)
+    {
+        //a cheap check whether anything has been received from the controller since the previous refresh
+        const uint32_t sequence = m_p_telemetry->get_sequence(node_id);
+        if(sequence == 0) continue;     //never heard of
+        int row = m_row_of_node[node_id];
+        if(row >= 0 && m_rows[row].sequence == sequence) continue;
+
+        servosila::node_snapshot snapshot;
+        m_p_telemetry->read(node_id, snapshot);
+        if(snapshot.received == 0) continue;    //forgotten by telemetry_store::reset(), nothing received since
+        if(row < 0) row = insert_row(node_id);
+        update_row(row, snapshot);
+    }
+}
+
+void NodeTableModel::clear()
+{
+    beginResetModel();
+    m_rows.clear();
+    for(uint32_t node_id=0; node_id<=MAX_NODE_ID; node_id++) m_row_of_node[node_id] = -1;
+    endResetModel();
+}
+
+uint32_t NodeTableModel::get_node_id(int row) const
+{
+    if(row < 0 || row >= static_cast<int>(m_rows.size())) return 0;
+    return m_rows[row].node_id;
+}
+
+//a newly discovered controller gets a row in the order of Node IDs
+int NodeTableModel::insert_row(uint32_t node_id)
+{
+    int row = 0;
+    while(row < static_cast<int>(m_rows.size()) && m_rows[row].node_id < node_id) row++;
+
+    beginInsertRows(QModelIndex(), row, row);
+    node_row new_row;
+    new_row.node_id    = node_id;
+    new_row.sequence   = 0;
+    new_row.is_faulted = false;
+    new_row.cells[COLUMN_NODE_ID] = QString::number(node_id);
+    m_rows.insert(m_rows.begin() + row, new_row);
+    for(int i=row; i<static_cast<int>(m_rows.size()); i++) m_row_of_node[m_rows[i].node_id] = i;
+    endInsertRows();
+
+    return row;
+}
+
+//formats the telemetry of a controller and reports the range of the cells whose text has changed
+void NodeTableModel::update_row(int row, const servosila::node_snapshot& snapshot)
+{
+    node_row& r = m_rows[row];
+    r.sequence = snapshot.sequence;
+
+    //the text is compared rather than the values: a change below the displayed precision does not repaint anything
+    QString cells[COLUMN_COUNT];
+    cells[COLUMN_NODE_ID] = r.cells[COLUMN_NODE_ID];
+    const servosila::node_telemetry& t = snapshot.telemetry;
+    if(snapshot.received & 0x1)
+    {
+        float speed = t.pdo_180.speed;
+        if(fabsf(speed) < 0.05f) speed = 0.0;   //cosmetics: no flickering "-0.0"
+        cells[COLUMN_FAULT_BITS] = "0x" + QString("%1").arg(t.pdo_180.fault_bits, 4, 16, QChar('0')).toUpper();
+        cells[COLUMN_VOLTAGE]    = QString::number(t.pdo_180.Udc, 'f', 1);
+        cells[COLUMN_SPEED]      = QString::number(speed, 'f', 1);
+    }
+    //the formats of the channels are defined in Servosila Device Reference document for your device; shown raw here
+    const int16_t* channels[3] = { t.pdo_280.channel, t.pdo_380.channel, t.pdo_480.channel };
+    for(int i=0; i<3; i++)
+    {
+        if(!(snapshot.received & (0x2 << i))) continue;
+        const int16_t* channel = channels[i];
+        cells[COLUMN_CHANNELS_280 + i] = QString("%1 %2 %3 %4").arg(channel[0]).arg(channel[1]).arg(channel[2]).arg(channel[3]);
+    }
+
+    int first_changed = COLUMN_COUNT;
+    int last_changed  = -1;
+    for(int c=0; c<COLUMN_COUNT; c++)
+    {
+        if(cells[c] == r.cells[c]) continue;
+        r.cells[c] = cells[c];
+        if(c < first_changed) first_changed = c;
+        last_changed = c;
+    }
+    const bool is_faulted = (snapshot.received & 0x1) && t.pdo_180.fault_bits != 0;
+    if(is_faulted != r.is_faulted)
+    {   //the colour of the Fault Bits cell changes as well
+        r.is_faulted = is_faulted;
+        if(COLUMN_FAULT_BITS < first_changed) first_changed = COLUMN_FAULT_BITS;
+        if(COLUMN_FAULT_BITS > last_changed)  last_changed  = COLUMN_FAULT_BITS;
+    }
+    if(last_changed < 0) return;    //nothing visible has changed
+
+    emit dataChanged(index(row, first_changed), index(row, last_changed));
+}
+
+int NodeTableModel::rowCount(const QModelIndex &parent) const
+{
+    if(parent.isValid()) return 0;
+    return static_cast<int>(m_rows.size());
+}
+
+int NodeTableModel::columnCount(const QModelIndex &parent) const
+{
+    if(parent.isValid()) return 0;
+    return COLUMN_COUNT;
+}
+
+QVariant NodeTableModel::data(const QModelIndex &index, int role) const
+{
+    if(!index.isValid() || index.row() >= static_cast<int>(m_rows.size()) || index.column() >= COLUMN_COUNT) return QVariant();
+    const node_row& r = m_rows[index.row()];
+
+    switch(role)
+    {
+        case Qt::DisplayRole:
+            return r.cells[index.column()];
+        case Qt::TextAlignmentRole:
+            return (index.column() == COLUMN_NODE_ID) ? int(Qt::AlignCenter) : int(Qt::AlignRight | Qt::AlignVCenter);
+        case Qt::BackgroundRole:
+            if(index.column() == COLUMN_FAULT_BITS && r.is_faulted) return QBrush(Qt::red);
+            break;
+    }
+    return QVariant();
+}
+
+QVariant NodeTableModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if(role != Qt::DisplayRole || orientation != Qt::Horizontal) return QVariant();
+
+    switch(section)
+    {
+        case COLUMN_NODE_ID:        return tr("Node ID");
+        case COLUMN_FAULT_BITS:     return tr("Fault Bits");
+        case COLUMN_VOLTAGE:        return tr("Udc, V");
+        case COLUMN_SPEED:          return tr("Speed, Hz");
+        case COLUMN_CHANNELS_280:   return tr("0x280");
+        case COLUMN_CHANNELS_380:   return tr("0x380");
+        case COLUMN_CHANNELS_480:   return tr("0x480");
+    }
+    return QVariant();
+}
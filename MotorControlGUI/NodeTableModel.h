@@ -0,0 +1,81 @@
+/////////////////////////////////////////////////////////////////////////////
+//
+//  This sample source code comes with Servosila SC-25C Brushless Motor Controllers.
+//      OS: Windows or Linux
+//      Interface to SC-25: SLCAN via USB virtual serial port
+//
+//  The code is provided "AS IS" without any kind of guarantees or warranties.
+//  Use it at your own risk.
+//
+//  The code is free for everyone to use, modify or redistribute.
+//
+//  www.servosila.com
+//
+/////////////////////////////////////////////////////////////////////////////
+
+#ifndef NODETABLEMODEL_H
+#define NODETABLEMODEL_H
+
+#include "../servosila-common/telemetry-store.h"
+
+#include <QAbstractTableModel>
+#include <QString>
+#include <vector>
+
+//A table of all controllers heard on the CAN network, one row per Node ID, sorted by Node ID.
+//...A controller gets its row as soon as its first telemetry message arrives; nothing needs to be configured.
+//...refresh() is called at the display rate: it skips the controllers whose telemetry has not changed since
+//...the previous refresh, and reports only the cells whose displayed text has changed, so that the view
+//...repaints a few cells rather than the whole table, however many controllers there are.
+class NodeTableModel : public QAbstractTableModel
+{
+    Q_OBJECT
+
+public:
+    //'p_telemetry' is read with the lock-free reader side of the telemetry store
+    explicit NodeTableModel(const servosila::telemetry_store* p_telemetry, QObject *parent = nullptr);
+
+    //picks up new controllers and changed telemetry
+    void refresh();
+    //forgets all controllers, e.g. after reconnecting
+    void clear();
+    //the Node ID shown in a row; 0 if there is no such row
+    uint32_t get_node_id(int row) const;
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+
+private:
+    enum column
+    {
+        COLUMN_NODE_ID,
+        COLUMN_FAULT_BITS,
+        COLUMN_VOLTAGE,
+        COLUMN_SPEED,
+        COLUMN_CHANNELS_280,
+        COLUMN_CHANNELS_380,
+        COLUMN_CHANNELS_480,
+        COLUMN_COUNT
+    };
+    static const uint32_t MAX_NODE_ID = 127;
+
+    struct node_row
+    {
+        uint32_t node_id;
+        uint32_t sequence;              //the telemetry sequence number the row has been filled from
+        bool     is_faulted;
+        QString  cells[COLUMN_COUNT];   //the displayed text
+    };
+
+    const servosila::telemetry_store* m_p_telemetry;
+    std::vector<node_row> m_rows;
+    //the row of every Node ID; -1 if the controller has not been heard yet
+    int m_row_of_node[MAX_NODE_ID + 1];
+
+private:
+    int insert_row(uint32_t node_id);
+    void update_row(int row, const servosila::node_snapshot& snapshot);
+};
+#endif // NODETABLEMODEL_H
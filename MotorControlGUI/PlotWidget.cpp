@@ -0,0 +1,154 @@
+/////////////////////////////////////////////////////////////////////////////
+//
+//  This sample source code comes with Servosila SC-25C Brushless Motor Controllers.
+//      OS: Windows or Linux
+//      Interface to SC-25: SLCAN via USB virtual serial port
+//
+//  The code is provided "AS IS" without any kind of guarantees or warranties.
+//  Use it at your own risk.
+//
+//  The code is free for everyone to use, modify or redistribute.
+//
+//  www.servosila.com
+//
+/////////////////////////////////////////////////////////////////////////////
+
+#include "PlotWidget.h"
+#include "../servosila-common/monotonic-clock.h"    //monotonic_ns()
+#include <QPainter>
+
+PlotWidget::PlotWidget(QWidget *parent)
+    : QWidget(parent)
+    , m_node_id(1)
+{
+    setMinimumHeight(240);
+    //the whole widget is painted in paintEvent(), no need for Qt to erase the background first
+    setAttribute(Qt::WA_OpaquePaintEvent);
+}
+
+void PlotWidget::add_sample(uint32_t node_id, uint64_t timestamp_ns, uint16_t fault_bits, float Udc, float speed)
+{
+    if(node_id > MAX_NODE_ID) return;
+    if(!m_histories[node_id]) m_histories[node_id].reset(new node_history());
+
+    node_history& history = *(m_histories[node_id]);
+    history.channels[CHANNEL_SPEED].add(timestamp_ns, speed);
+    history.channels[CHANNEL_VOLTAGE].add(timestamp_ns, Udc);
+    history.channels[CHANNEL_FAULT_BITS].add(timestamp_ns, static_cast<float>(fault_bits));
+}
+
+void PlotWidget::set_node_id(uint32_t node_id)
+{
+    m_node_id = node_id;
+    update();
+}
+
+void PlotWidget::clear()
+{
+    for(uint32_t node_id=0; node_id<=MAX_NODE_ID; node_id++)
+    {
+        if(!m_histories[node_id]) continue;
+        for(size_t ch=0; ch<CHANNEL_COUNT; ch++) m_histories[node_id]->channels[ch].clear();
+    }
+    update();
+}
+
+void PlotWidget::paintEvent(QPaintEvent *event)
+{
+    Q_UNUSED(event);
+
+    QPainter painter(this);
+    painter.fillRect(rect(), palette().base());
+
+    //three strips of equal height, the newest samples on the right; the plots scroll with the clock, not with the samples
+    const uint64_t end_ns = servosila::monotonic_ns();
+    const qreal strip_height = height() / 3.0;
+    draw_channel(painter, QRectF(0, 0,                width(), strip_height), CHANNEL_SPEED,      tr("Speed, Hz"),    end_ns);
+    draw_channel(painter, QRectF(0, strip_height,     width(), strip_height), CHANNEL_VOLTAGE,    tr("Udc, V"),       end_ns);
+    draw_channel(painter, QRectF(0, 2 * strip_height, width(), strip_height), CHANNEL_FAULT_BITS, tr("Fault Bits"),   end_ns);
+}
+
+void PlotWidget::draw_channel(QPainter& painter, const QRectF& area, channel ch, const QString& title, uint64_t end_ns)
+{
+    painter.setPen(palette().mid().color());
+    painter.drawRect(area.adjusted(0, 0, -1, -1));
+    painter.setPen(palette().text().color());
+    painter.drawText(area.adjusted(4, 2, -4, -2), Qt::AlignLeft | Qt::AlignTop, title);
+
+    if(m_node_id > MAX_NODE_ID || !m_histories[m_node_id]) return;     //nothing received from the controller yet
+
+    //one column per pixel: this is what bounds the cost of drawing
+    const size_t column_count = static_cast<size_t>(area.width());
+    if(column_count == 0) return;
+    m_columns.resize(column_count);
+    m_histories[m_node_id]->channels[ch].decimate(end_ns, &(m_columns[0]), column_count);
+
+    //the vertical scale fits the visible range
+    float minimum = 0.0;
+    float maximum = 0.0;
+    bool  is_empty = true;
+    for(size_t x=0; x<column_count; x++)
+    {
+        const servosila::min_max_history::column& c = m_columns[x];
+        if(!c.is_valid) continue;
+        if(is_empty || c.minimum < minimum) minimum = c.minimum;
+        if(is_empty || c.maximum > maximum) maximum = c.maximum;
+        is_empty = false;
+    }
+    if(is_empty) return;
+    if(maximum - minimum < 1.0f)
+    {   //a flat line is drawn in the middle of the strip
+        minimum -= 0.5f;
+        maximum += 0.5f;
+    }
+
+    const qreal top    = area.top() + 16;     //below the title
+    const qreal bottom = area.bottom() - 2;
+    const qreal scale  = (bottom - top) / (maximum - minimum);
+
+    //every column is a vertical line from its minimum to its maximum...
+    //...extended to the previous column, so that a steep change shows as a continuous line;
+    //...at low telemetry rates most columns are empty, and the columns that have samples are joined by straight lines.
+    m_lines.clear();
+    bool   has_previous = false;
+    size_t previous_x = 0;
+    float  previous_minimum = 0.0;
+    float  previous_maximum = 0.0;
+    for(size_t x=0; x<column_count; x++)
+    {
+        const servosila::min_max_history::column& c = m_columns[x];
+        if(!c.is_valid) continue;
+
+        float low  = c.minimum;
+        float high = c.maximum;
+        if(has_previous && previous_x + 1 == x)
+        {
+            if(previous_maximum < low)  low  = previous_maximum;
+            if(previous_minimum > high) high = previous_minimum;
+        }
+        else if(has_previous)
+        {
+            const qreal previous_y = bottom - ((previous_minimum + previous_maximum) / 2 - minimum) * scale;
+            const qreal y          = bottom - ((c.minimum + c.maximum) / 2 - minimum) * scale;
+            m_lines.append(QLineF(area.left() + previous_x + 0.5, previous_y, area.left() + x + 0.5, y));
+        }
+
+        const qreal px     = area.left() + x + 0.5;
+        const qreal y_low  = bottom - (low  - minimum) * scale;
+        qreal       y_high = bottom - (high - minimum) * scale;
+        if(y_low - y_high < 1.0) y_high = y_low - 1.0;      //at least one pixel tall
+        m_lines.append(QLineF(px, y_low, px, y_high));
+
+        has_previous     = true;
+        previous_x       = x;
+        previous_minimum = c.minimum;
+        previous_maximum = c.maximum;
+    }
+    painter.setPen(palette().highlight().color());
+    painter.drawLines(m_lines);
+
+    //the visible range
+    painter.setPen(palette().text().color());
+    painter.drawText(area.adjusted(4, 2, -4, -2), Qt::AlignRight | Qt::AlignTop,
+                     QString("%1 .. %2").arg(minimum, 0, 'g', 4).arg(maximum, 0, 'g', 4));
+}
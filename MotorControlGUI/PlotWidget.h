@@ -0,0 +1,74 @@
+/////////////////////////////////////////////////////////////////////////////
+//
+//  This sample source code comes with Servosila SC-25C Brushless Motor Controllers.
+//      OS: Windows or Linux
+//      Interface to SC-25: SLCAN via USB virtual serial port
+//
+//  The code is provided "AS IS" without any kind of guarantees or warranties.
+//  Use it at your own risk.
+//
+//  The code is free for everyone to use, modify or redistribute.
+//
+//  www.servosila.com
+//
+/////////////////////////////////////////////////////////////////////////////
+
+#ifndef PLOTWIDGET_H
+#define PLOTWIDGET_H
+
+#include "../servosila-common/min-max-history.h"
+
+#include <QWidget>
+#include <QVector>
+#include <QLineF>
+#include <memory>           //std::unique_ptr
+#include <vector>           //preallocated drawing buffers
+
+//A strip chart of the speed, the input voltage and the fault bits of one controller over the latest 10 seconds.
+//...The samples of every controller go into min/max histories of a fixed size, so the cost of a sample does not depend
+//...on the telemetry rate, and the cost of a redraw depends only on the width of the widget.
+//...The widget does not repaint itself; the owner calls update() at the display rate.
+class PlotWidget : public QWidget
+{
+    Q_OBJECT
+
+public:
+    explicit PlotWidget(QWidget *parent = nullptr);
+
+    //adds a 0x180 telemetry sample of a controller; 'timestamp_ns' is monotonic_ns() time
+    void add_sample(uint32_t node_id, uint64_t timestamp_ns, uint16_t fault_bits, float Udc, float speed);
+    //selects the controller whose history is shown
+    void set_node_id(uint32_t node_id);
+    //forgets the history of all controllers
+    void clear();
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+
+private:
+    enum channel
+    {
+        CHANNEL_SPEED,
+        CHANNEL_VOLTAGE,
+        CHANNEL_FAULT_BITS,
+        CHANNEL_COUNT
+    };
+    static const uint32_t MAX_NODE_ID = 127;
+
+    struct node_history
+    {
+        servosila::min_max_history channels[CHANNEL_COUNT];
+    };
+
+    //a history is allocated on the first sample of a controller (about 100 KB each)
+    std::unique_ptr<node_history> m_histories[MAX_NODE_ID + 1];
+    //the controller whose history is shown
+    uint32_t m_node_id;
+    //drawing buffers, reused from one redraw to the next
+    std::vector<servosila::min_max_history::column> m_columns;
+    QVector<QLineF> m_lines;
+
+private:
+    void draw_channel(QPainter& painter, const QRectF& area, channel ch, const QString& title, uint64_t end_ns);
+};
+#endif // PLOTWIDGET_H
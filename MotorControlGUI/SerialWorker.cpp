@@ -0,0 +1,160 @@
+/////////////////////////////////////////////////////////////////////////////
+//
+//  This sample source code comes with Servosila SC-25C Brushless Motor Controllers.
+//      OS: Windows or Linux
+//      Interface to SC-25: SLCAN via USB virtual serial port
+//
+//  The code is provided "AS IS" without any kind of guarantees or warranties.
+//  Use it at your own risk.
+//
+//  The code is free for everyone to use, modify or redistribute.
+//
+//  www.servosila.com
+//
+/////////////////////////////////////////////////////////////////////////////
+
+#include "SerialWorker.h"
+#include "../servosila-common/monotonic-clock.h"    //monotonic_ns()
+
+SerialWorker::SerialWorker(servosila::telemetry_store* p_telemetry, servosila::spsc_queue<telemetry_sample>* p_samples, QObject* parent)
+    : QObject(parent)
+    , m_p_serial_port(new QSerialPort(this))    //the children move to the I/O thread together with the worker
+    , m_p_command_timer(new QTimer(this))
+    , m_p_telemetry(p_telemetry)
+    , m_p_samples(p_samples)
+    , m_node_id(1)
+    , m_is_sending_ongoing(false)
+{
+    //the telemetry is read out as soon as it arrives rather than on a timer tick
+    connect(m_p_serial_port, &QSerialPort::readyRead, this, &SerialWorker::read_telemetry);
+
+    //This timer's period is how often the scheduler is asked for commands that are due; it is not the command rate.
+    //Do not send commands to the contoller too often, as the controller's CPU might be overloaded by the incoming USB traffic...
+    //...the rate is set by the scheduler in start_sending().
+    connect(m_p_command_timer, &QTimer::timeout, this, &SerialWorker::send_commands);
+    m_p_command_timer->setTimerType(Qt::PreciseTimer);
+    m_p_command_timer->setInterval(10);  //ms
+}
+
+void SerialWorker::open_port(const QString& port_name, uint32_t node_id)
+{
+    close_port();
+    m_node_id = node_id;
+
+    //the controllers of the previous connection are forgotten; the GUI thread may be reading the store meanwhile
+    m_p_telemetry->reset();
+
+    //filtering telemetry messages of all controllers on CAN network; they all appear on the dashboard...
+    //...the decoder drops other messages before decoding their payload.
+    //...add_node_id() narrows the filter down to the controllers of interest, if needed.
+    servosila::can_id_filter filter;
+    filter.add_cob_id(0x180);
+    filter.add_cob_id(0x280);
+    filter.add_cob_id(0x380);
+    filter.add_cob_id(0x480);
+    m_decoder.set_filter(filter);
+
+    //connecting to a selected serial port
+    m_p_serial_port->setPortName(port_name);
+    const bool result = m_p_serial_port->open(QIODevice::ReadWrite);
+    if(result) m_p_command_timer->start();
+
+    emit port_opened(result);
+}
+
+void SerialWorker::close_port()
+{
+    m_p_command_timer->stop();
+    m_scheduler.remove_node(m_node_id);
+    m_is_sending_ongoing = false;
+    if(m_p_serial_port->isOpen()) m_p_serial_port->close();
+}
+
+//starts periodic sending of the Electronic Speed Control command
+void SerialWorker::start_sending(float speed_target)
+{
+    //100ms=10Hz refresh; a changed speed target goes out early, but not sooner than 20ms after the previous command
+    m_scheduler.add_node(m_node_id, 100000000ull, 20000000ull, servosila::monotonic_ns());
+    m_is_sending_ongoing = true;
+    set_speed_target(speed_target);
+}
+
+void SerialWorker::set_speed_target(float speed_target)
+{
+    if(!m_is_sending_ongoing) return;
+    m_scheduler.set_command(servosila::make_esc_command(m_node_id, speed_target));
+}
+
+//stops periodic sending and sends out a STOP command to the controller (once)
+void SerialWorker::stop_sending()
+{
+    m_scheduler.remove_node(m_node_id);
+    m_is_sending_ongoing = false;
+
+    if(!m_p_serial_port->isOpen()) return;
+    m_command_builder.clear_batch();
+    m_command_builder.append_stop(m_node_id);
+    write_batch();
+}
+
+//stops periodic sending and sends out a RESET command to the controller
+void SerialWorker::send_reset()
+{
+    m_scheduler.remove_node(m_node_id);
+    m_is_sending_ongoing = false;
+
+    if(!m_p_serial_port->isOpen()) return;
+    m_command_builder.clear_batch();
+    m_command_builder.append_reset(m_node_id);
+    write_batch();
+}
+
+//This routine is called whenever the serial port has new symbols
+void SerialWorker::read_telemetry()
+{
+    //Reading out all available symbols block by block from the virtual serial port
+    while(true)
+    {
+        //reading out as many symbols as are available, up to the size of the buffer
+        const qint64 nread = m_p_serial_port->read(m_read_buffer, sizeof(m_read_buffer));
+        if(nread <= 0) break;   //no symbols left to be read out from the virtual serial port
+
+        //feeding the whole block to the SLCAN decoder object...
+        //...every decoded telemetry message updates the controller's slot in the telemetry store;
+        //...the GUI sees only the latest state of each controller, however many messages have arrived since its previous refresh.
+        m_decoder.process_buffer(m_read_buffer, static_cast<size_t>(nread), [this](const servosila::can_message& message)
+        {
+            const uint64_t timestamp_ns = servosila::monotonic_ns();
+            if(m_p_telemetry->update(message, timestamp_ns) != 0x180) return;
+
+            //queuing the sample for the plots; if the GUI falls behind and the queue is full, the sample is dropped
+            const uint32_t node_id = servosila::extract_node_id_from_can_id(message.can_id);
+            const servosila::telemetry_180& pdo_180 = m_p_telemetry->get_latest(node_id).telemetry.pdo_180;
+            telemetry_sample sample;
+            sample.timestamp_ns = timestamp_ns;
+            sample.node_id      = node_id;
+            sample.fault_bits   = pdo_180.fault_bits;
+            sample.Udc          = pdo_180.Udc;
+            sample.speed        = pdo_180.speed;
+            m_p_samples->try_push(sample);
+        });
+    }
+}
+
+//This routine is called every 10ms by the command timer
+void SerialWorker::send_commands()
+{
+    servosila::can_message messages[4];
+    const size_t nmessages = m_scheduler.collect(servosila::monotonic_ns(), messages, 4);
+    if(nmessages == 0) return;
+
+    m_command_builder.clear_batch();
+    for(size_t i=0; i<nmessages; i++) m_command_builder.append(messages[i]);
+    write_batch();
+}
+
+//writing the SLCAN text of the batched commands to the virtual serial port
+void SerialWorker::write_batch()
+{
+    m_p_serial_port->write(m_command_builder.get_batch(), m_command_builder.get_batch_size());
+}
@@ -0,0 +1,92 @@
+/////////////////////////////////////////////////////////////////////////////
+//
+//  This sample source code comes with Servosila SC-25C Brushless Motor Controllers.
+//      OS: Windows or Linux
+//      Interface to SC-25: SLCAN via USB virtual serial port
+//
+//  The code is provided "AS IS" without any kind of guarantees or warranties.
+//  Use it at your own risk.
+//
+//  The code is free for everyone to use, modify or redistribute.
+//
+//  www.servosila.com
+//
+/////////////////////////////////////////////////////////////////////////////
+
+#ifndef SERIALWORKER_H
+#define SERIALWORKER_H
+
+#include "../servosila-common/slcan-command-builder.h"
+#include "../servosila-common/slcan-buffer-decoder.h"
+#include "../servosila-common/command-scheduler.h"
+#include "../servosila-common/telemetry-store.h"
+#include "../servosila-common/spsc-queue.h"
+
+#include <QObject>
+#include <QTimer>           //periodic command timer
+#include <QSerialPort>      //creoss-platform Serial Port API encapsulation
+
+//Every 0x180 telemetry message as it arrives, for the plots; the telemetry store keeps only the latest one.
+struct telemetry_sample
+{
+    uint64_t timestamp_ns;  //monotonic_ns() time of arrival
+    uint32_t node_id;
+    uint16_t fault_bits;
+    float    Udc;
+    float    speed;
+};
+
+//The worker owns the serial port and lives in its own I/O thread, so that GUI redraws never delay the CAN traffic:
+//...- the telemetry is read out and decoded as soon as the serial port signals readyRead,
+//...  and published to a lock-free telemetry store that the GUI reads at its own display rate;
+//...- every 0x180 message is also queued as a sample for the plots, through a lock-free queue;
+//...- the commands are sent by a command scheduler from a 10ms timer of the I/O thread.
+//The GUI controls the worker through its slots only, with queued signal-slot connections.
+class SerialWorker : public QObject
+{
+    Q_OBJECT
+
+public:
+    //'p_telemetry' and 'p_samples' must outlive the I/O thread; the worker is their only writer
+    SerialWorker(servosila::telemetry_store* p_telemetry, servosila::spsc_queue<telemetry_sample>* p_samples, QObject* parent = nullptr);
+
+public slots:
+    void open_port(const QString& port_name, uint32_t node_id);
+    void close_port();
+    void start_sending(float speed_target);
+    void set_speed_target(float speed_target);
+    void stop_sending();
+    void send_reset();
+
+signals:
+    //emitted in response to open_port(); 'is_opened' is false if the serial port cannot be opened
+    void port_opened(bool is_opened);
+
+private:
+    //cross-platform Serial Port object
+    QSerialPort* m_p_serial_port;
+    //periodic timer of the command scheduler
+    QTimer* m_p_command_timer;
+    //the latest telemetry of every controller; read by the GUI thread
+    servosila::telemetry_store* m_p_telemetry;
+    //the samples for the plots; popped by the GUI thread
+    servosila::spsc_queue<telemetry_sample>* m_p_samples;
+    //SLCAN decoder object
+    servosila::slcan_buffer_decoder m_decoder;
+    //pre-encoded SLCAN text of the commands to the controller
+    servosila::slcan_command_builder m_command_builder;
+    //decides when the ESC command is repeated
+    servosila::command_scheduler m_scheduler;
+    //a buffer for reading out symbols from the serial port in large blocks
+    char m_read_buffer[4096];
+    //Node ID of the controller
+    uint32_t m_node_id;
+    //the ESC command is being sent periodically
+    bool m_is_sending_ongoing;
+
+private:
+    void read_telemetry();
+    void send_commands();
+    void write_batch();
+};
+#endif // SERIALWORKER_H
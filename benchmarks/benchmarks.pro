@@ -0,0 +1,29 @@
+TEMPLATE = app
+CONFIG += console c++11
+CONFIG -= app_bundle
+CONFIG -= qt
+CONFIG += release
+
+SOURCES += \
+        main.cpp
+
+HEADERS += \
+    ../servosila-common/canopen-decoder.h \
+    ../servosila-common/commands.h \
+    ../servosila-common/can-id-filter.h \
+    ../servosila-common/can-message.h \
+    ../servosila-common/command-scheduler.h \
+    ../servosila-common/float16-batch.h \
+    ../servosila-common/frame-log-reader.h \
+    ../servosila-common/frame-logger.h \
+    ../servosila-common/hex-codec.h \
+    ../servosila-common/instrumentation.h \
+    ../servosila-common/mapped-file.h \
+    ../servosila-common/min-max-history.h \
+    ../servosila-common/monotonic-clock.h \
+    ../servosila-common/slcan-buffer-decoder.h \
+    ../servosila-common/slcan-command-builder.h \
+    ../servosila-common/slcan-encoder.h \
+    ../servosila-common/slcan-message-encoder.h \
+    ../servosila-common/telemetry-decoder.h \
+    ../servosila-common/telemetry-store.h
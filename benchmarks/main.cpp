@@ -0,0 +1,585 @@
+///////////////////////////////////////////////////////////////////////////////////////////////
+//
+//  This sample source code comes with Servosila SC-25C Brushless Motor Controllers.
+//
+//  Benchmarks of the routines that every CAN frame goes through: SLCAN encoding and decoding,
+//  FLOAT16 conversion, CAN ID splitting and telemetry (PDO) decoding.
+//  Before benchmarking, the vectorized and table-based routines are checked against their scalar counterparts,
+//  and the command scheduler is checked to spread the controllers over the refresh period.
+//      OS: Linux
+//
+//  Usage: benchmarks [capture]
+//      capture  an optional binary frame log (see frame-logger.h) or raw SLCAN text capture
+//               to be benchmarked in addition to the synthetic data
+//
+//  Build in release mode; the figures of a debug build mean nothing.
+//
+//  The code is provided "AS IS" without any kind of guarantees or warranties.
+//  Use it at your own risk.
+//
+//  The code is free for everyone to use, modify or redistribute.
+//
+//  www.servosila.com
+//
+///////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "../servosila-common/slcan-encoder.h"          //SLCAN encoder function
+#include "../servosila-common/slcan-buffer-decoder.h"   //SLCAN decoder class
+#include "../servosila-common/slcan-message-encoder.h"  //vectorized SLCAN encoder
+#include "../servosila-common/slcan-command-builder.h"  //preformatted SLCAN commands
+#include "../servosila-common/command-scheduler.h"      //staggered commands
+#include "../servosila-common/hex-codec.h"              //vectorized hex conversion
+#include "../servosila-common/float16-batch.h"          //batch FLOAT16 conversion
+#include "../servosila-common/canopen-decoder.h"        //CANopen decoding functions
+#include "../servosila-common/telemetry-store.h"        //telemetry decoding
+#include "../servosila-common/mapped-file.h"            //memory-mapped captures
+#include "../servosila-common/min-max-history.h"        //plot history
+#include "../servosila-common/instrumentation.h"        //latency histograms
+#include "../servosila-common/frame-log-reader.h"       //binary frame logs
+#include "../servosila-common/monotonic-clock.h"        //monotonic_ns()
+#include <iostream>                                     //console output
+#include <iomanip>                                      //table formatting
+#include <string>                                       //SLCAN text buffers
+#include <vector>                                       //test data
+#include <string.h>                                     //memcpy()
+#include <stdint.h>                                     //standard integer types
+
+//a sink for the results of benchmarked routines, so that the compiler does not throw the work away
+volatile uint32_t sink = 0;
+
+//every benchmark runs for at least this long; the figure is the best of several trials
+const uint64_t MIN_DURATION_NS = 200000000ull;  //200ms
+const int      TRIAL_COUNT     = 5;
+
+//a small deterministic pseudo-random generator, so that every run benchmarks the same data
+uint32_t random_state = 12345;
+uint32_t next_random()
+{
+    random_state = random_state * 1664525u + 1013904223u;
+    return random_state >> 8;
+}
+
+//Runs 'body' (which processes 'frame_count' frames per call) repeatedly and prints ns/frame and frames/s
+template<typename Body>
+void run_benchmark(const char* name, size_t frame_count, Body body)
+{
+    body();     //warming up caches and branch predictors
+
+    double best_ns_per_frame = 0.0;
+    for(int trial=0; trial<TRIAL_COUNT; trial++)
+    {
+        uint64_t run_count = 0;
+        const uint64_t start_ns = servosila::monotonic_ns();
+        uint64_t elapsed_ns = 0;
+        do
+        {
+            body();
+            run_count++;
+            elapsed_ns = servosila::monotonic_ns() - start_ns;
+        } while(elapsed_ns < MIN_DURATION_NS / TRIAL_COUNT);
+
+        const double ns_per_frame = static_cast<double>(elapsed_ns) / static_cast<double>(run_count * frame_count);
+        if(trial == 0 || ns_per_frame < best_ns_per_frame) best_ns_per_frame = ns_per_frame;
+    }
+
+    std::cout<<std::left<<std::setw(44)<<name<<std::right
+             <<std::setw(10)<<std::fixed<<std::setprecision(2)<<best_ns_per_frame<<" ns/frame"
+             <<std::setw(14)<<std::setprecision(0)<<1e9 / best_ns_per_frame<<" frames/s"<<'\n';
+}
+
+//Synthetic telemetry traffic: 0x180..0x480 messages from 32 controllers with random payloads
+std::vector<servosila::can_message> make_messages(size_t count)
+{
+    std::vector<servosila::can_message> messages(count);
+    for(size_t i=0; i<count; i++)
+    {
+        servosila::can_message& message = messages[i];
+        message.can_id = 0x180 + 0x100 * (next_random() % 4) + 1 + (next_random() % 32);
+        message.length = 8;
+        for(size_t j=0; j<8; j++) message.payload[j] = static_cast<uint8_t>(next_random());
+    }
+    return messages;
+}
+
+//encodes messages into SLCAN text the way a USB-CAN adapter sends them
+std::string make_slcan_text(const std::vector<servosila::can_message>& messages)
+{
+    std::string text;
+    char buffer[32];
+    for(size_t i=0; i<messages.size(); i++)
+    {
+        const size_t size = servosila::slcan_encode_11bit(messages[i].can_id, messages[i].payload, messages[i].length, buffer);
+        text.append(buffer, size);
+    }
+    return text;
+}
+
+//the worst case for the decoder: valid frames mixed with line noise, truncated frames, bad hex digits and overlong garbage
+std::string make_noisy_slcan_text(const std::vector<servosila::can_message>& messages)
+{
+    std::string text;
+    char buffer[32];
+    for(size_t i=0; i<messages.size(); i++)
+    {
+        const size_t size = servosila::slcan_encode_11bit(messages[i].can_id, messages[i].payload, messages[i].length, buffer);
+        switch(next_random() % 8)
+        {
+            case 0:     //random bytes before the frame
+                for(size_t j=next_random() % 16; j>0; j--) text.push_back(static_cast<char>(next_random()));
+                text.append(buffer, size);
+                break;
+            case 1:     //a truncated frame
+                text.append(buffer, size / 2);
+                text.push_back('\r');
+                break;
+            case 2:     //a bad hex digit
+                buffer[5 + next_random() % 16] = 'x';
+                text.append(buffer, size);
+                break;
+            case 3:     //garbage longer than any valid frame
+                for(size_t j=0; j<64; j++) text.push_back(static_cast<char>('0' + next_random() % 10));
+                text.push_back('\r');
+                break;
+            default:
+                text.append(buffer, size);
+                break;
+        }
+    }
+    return text;
+}
+
+//feeds SLCAN text to a decoder in blocks of the size the telemetry examples read from the serial port
+size_t decode_slcan(servosila::slcan_buffer_decoder& decoder, const char* text, size_t size)
+{
+    const size_t BLOCK_SIZE = 4096;
+    size_t nframes = 0;
+    for(size_t offset=0; offset<size; offset+=BLOCK_SIZE)
+    {
+        const size_t block_size = (size - offset < BLOCK_SIZE) ? (size - offset) : BLOCK_SIZE;
+        nframes += decoder.process_buffer(&(text[offset]), block_size, [](const servosila::can_message& message)
+        {
+            sink += message.payload[7];
+        });
+    }
+    return nframes;
+}
+
+//Checks that the vectorized hex routines give exactly the same results as the scalar ones:
+//...every byte value at every payload position, and every symbol value at every symbol position.
+bool verify_hex_codec()
+{
+    for(size_t position=0; position<8; position++)
+    {
+        for(uint32_t value=0; value<256; value++)
+        {
+            uint8_t bytes[8] = { 0x01, 0x23, 0x45, 0x67, 0x89, 0xAB, 0xCD, 0xEF };
+            bytes[position] = static_cast<uint8_t>(value);
+
+            char vector_symbols[16], scalar_symbols[16];
+            servosila::encode_hex8(bytes, vector_symbols);
+            servosila::encode_hex_scalar(bytes, 8, scalar_symbols);
+            if(memcmp(vector_symbols, scalar_symbols, sizeof(scalar_symbols)) != 0) return false;
+
+            //the encoder must agree with slcan_encode_11bit() on every 11-bit frame
+            servosila::can_message message;
+            message.can_id = static_cast<uint32_t>((value << 3) | position);
+            message.length = 8;
+            memcpy(message.payload, bytes, sizeof(bytes));
+            char frame[servosila::SLCAN_MAX_FRAME_SIZE], reference[servosila::SLCAN_MAX_FRAME_SIZE];
+            const size_t frame_size = servosila::slcan_encode_message(message, frame);
+            const size_t reference_size = servosila::slcan_encode_11bit(message.can_id, message.payload, 8, reference);
+            if(frame_size != reference_size || memcmp(frame, reference, frame_size) != 0) return false;
+        }
+    }
+
+    for(size_t position=0; position<16; position++)
+    {
+        for(uint32_t symbol=0; symbol<256; symbol++)
+        {
+            char symbols[17] = "0123456789abcDEF";
+            symbols[position] = static_cast<char>(symbol);
+
+            uint8_t vector_bytes[8] = { 0 }, scalar_bytes[8] = { 0 };
+            const bool vector_result = servosila::decode_hex8(symbols, vector_bytes);
+            const bool scalar_result = servosila::decode_hex_scalar(symbols, 8, scalar_bytes);
+            if(vector_result != scalar_result) return false;
+            if(scalar_result && memcmp(vector_bytes, scalar_bytes, sizeof(scalar_bytes)) != 0) return false;
+
+            for(size_t count=0; count<8; count++)
+            {   //short payloads
+                uint8_t short_bytes[8] = { 0 };
+                if(servosila::decode_hex(symbols, count, short_bytes) != servosila::decode_hex_scalar(symbols, count, scalar_bytes)) return false;
+            }
+        }
+    }
+    return true;
+}
+
+//Checks that the table-based and the batch FLOAT16 conversions give exactly the same results as decode_float16()
+//...for all 65536 values; NaNs only need to stay NaNs.
+bool verify_float16()
+{
+    std::vector<int16_t> values(65536);
+    std::vector<float>   results(65536);
+    for(size_t i=0; i<values.size(); i++) values[i] = static_cast<int16_t>(static_cast<uint16_t>(i));
+    servosila::decode_float16_batch(values.data(), results.data(), values.size());
+
+    for(size_t i=0; i<values.size(); i++)
+    {
+        const float reference = servosila::decode_float16(values[i]);
+        const float candidates[2] = { servosila::decode_float16_table(values[i]), results[i] };
+        for(size_t j=0; j<2; j++)
+        {
+            if(reference != reference)
+            {
+                if(candidates[j] == candidates[j]) return false;
+            }
+            else if(memcmp(&reference, &(candidates[j]), sizeof(reference)) != 0) return false;
+        }
+    }
+    return true;
+}
+
+//Checks that the first commands of controllers go out at different times of the refresh period, even for
+//...Node IDs that are a multiple of 16 apart (5, 21, 37...), which shared a phase when it was taken from the Node ID.
+bool verify_command_scheduler()
+{
+    const uint64_t PERIOD_NS = 128000000ull;    //128ms: a phase is 1ms
+    const size_t   NODE_COUNT = 8;
+    servosila::command_scheduler scheduler(NODE_COUNT);
+    uint64_t first_ns[servosila::command_scheduler::MAX_NODE_ID + 1] = { 0 };
+    for(size_t i=0; i<NODE_COUNT; i++)
+    {
+        const uint32_t node_id = 5 + 16 * static_cast<uint32_t>(i);
+        scheduler.add_node(node_id, PERIOD_NS, 0, 0);
+        scheduler.set_command(servosila::make_esc_command(node_id, 1.0f));
+    }
+
+    servosila::can_message messages[NODE_COUNT];
+    for(uint64_t now_ns=0; now_ns<PERIOD_NS; now_ns+=PERIOD_NS/servosila::command_scheduler::PHASE_COUNT)
+    {
+        const size_t nmessages = scheduler.collect(now_ns, messages, NODE_COUNT);
+        for(size_t i=0; i<nmessages; i++)
+        {
+            const uint32_t node_id = messages[i].can_id & 0x7F;
+            if(first_ns[node_id] == 0) first_ns[node_id] = now_ns + 1;     //+1: 0 is "not sent yet"
+        }
+    }
+
+    for(size_t i=0; i<NODE_COUNT; i++)
+    {
+        const uint64_t t = first_ns[5 + 16 * i];
+        if(t == 0) return false;    //not sent within the refresh period
+        for(size_t j=0; j<i; j++) if(first_ns[5 + 16 * j] == t) return false;
+    }
+    return true;
+}
+
+servosila::telemetry_store telemetry;
+
+void benchmark_synthetic_data()
+{
+    const size_t COUNT = 4096;
+    const std::vector<servosila::can_message> messages = make_messages(COUNT);
+    const std::string text = make_slcan_text(messages);
+    const std::string noisy_text = make_noisy_slcan_text(messages);
+
+    std::cout<<"Synthetic data: "<<COUNT<<" frames, "<<text.size()<<" bytes of SLCAN text, "<<noisy_text.size()<<" bytes of noisy SLCAN text"<<'\n';
+
+    run_benchmark("slcan_encode_11bit()", COUNT, [&messages]()
+    {
+        char buffer[32];
+        for(size_t i=0; i<messages.size(); i++)
+        {
+            sink += static_cast<uint32_t>(servosila::slcan_encode_11bit(messages[i].can_id, messages[i].payload, 8, buffer));
+        }
+    });
+
+    run_benchmark("slcan_encode_message()", COUNT, [&messages]()
+    {
+        char buffer[servosila::SLCAN_MAX_FRAME_SIZE];
+        for(size_t i=0; i<messages.size(); i++)
+        {
+            sink += static_cast<uint32_t>(servosila::slcan_encode_message(messages[i], buffer));
+        }
+    });
+
+    //ESC commands to 8 controllers with a slowly changing speed, as a control loop would send them
+    static servosila::slcan_command_builder command_builder;
+    run_benchmark("ESC command, slcan_encode_message()", COUNT, []()
+    {
+        char buffer[servosila::SLCAN_MAX_FRAME_SIZE];
+        for(size_t i=0; i<COUNT; i++)
+        {
+            const servosila::can_message message = servosila::make_esc_command(1 + (i & 7), static_cast<float>(i >> 6));
+            const size_t size = servosila::slcan_encode_message(message, buffer);
+            sink += static_cast<uint8_t>(buffer[size - 2]) + static_cast<uint32_t>(size);
+        }
+    });
+
+    run_benchmark("ESC command, encode_esc()", COUNT, []()
+    {
+        for(size_t i=0; i<COUNT; i++)
+        {
+            size_t size = 0;
+            const char* text = command_builder.encode_esc(1 + (i & 7), static_cast<float>(i >> 6), size);
+            sink += static_cast<uint8_t>(text[size - 2]) + static_cast<uint32_t>(size);
+        }
+    });
+
+    run_benchmark("encode_hex_scalar(), 8 bytes", COUNT, [&messages]()
+    {
+        char symbols[16];
+        for(size_t i=0; i<messages.size(); i++)
+        {
+            servosila::encode_hex_scalar(messages[i].payload, 8, symbols);
+            sink += static_cast<uint8_t>(symbols[15]);
+        }
+    });
+
+    run_benchmark("encode_hex8()", COUNT, [&messages]()
+    {
+        char symbols[16];
+        for(size_t i=0; i<messages.size(); i++)
+        {
+            servosila::encode_hex8(messages[i].payload, symbols);
+            sink += static_cast<uint8_t>(symbols[15]);
+        }
+    });
+
+    std::vector<char> payload_symbols(16 * COUNT);
+    for(size_t i=0; i<COUNT; i++) servosila::encode_hex_scalar(messages[i].payload, 8, &(payload_symbols[16*i]));
+
+    run_benchmark("decode_hex_scalar(), 16 symbols", COUNT, [&payload_symbols]()
+    {
+        uint8_t bytes[8];
+        for(size_t i=0; i<payload_symbols.size(); i+=16)
+        {
+            sink += static_cast<uint32_t>(servosila::decode_hex_scalar(&(payload_symbols[i]), 8, bytes)) + bytes[7];
+        }
+    });
+
+    run_benchmark("decode_hex8()", COUNT, [&payload_symbols]()
+    {
+        uint8_t bytes[8];
+        for(size_t i=0; i<payload_symbols.size(); i+=16)
+        {
+            sink += static_cast<uint32_t>(servosila::decode_hex8(&(payload_symbols[i]), bytes)) + bytes[7];
+        }
+    });
+
+    servosila::slcan_buffer_decoder decoder;
+    run_benchmark("slcan_buffer_decoder::process_buffer()", COUNT, [&decoder, &text]()
+    {
+        sink += static_cast<uint32_t>(decode_slcan(decoder, text.data(), text.size()));
+    });
+
+    //a filter that rejects 3 of 4 messages right after the CAN ID is decoded
+    servosila::slcan_buffer_decoder filtering_decoder;
+    servosila::can_id_filter filter;
+    filter.add_cob_id(0x180);
+    filtering_decoder.set_filter(filter);
+    run_benchmark("process_buffer(), 0x180 filter", COUNT, [&filtering_decoder, &text]()
+    {
+        sink += static_cast<uint32_t>(decode_slcan(filtering_decoder, text.data(), text.size()));
+    });
+
+    servosila::slcan_buffer_decoder noisy_decoder;
+    run_benchmark("process_buffer(), noisy input", COUNT, [&noisy_decoder, &noisy_text]()
+    {
+        sink += static_cast<uint32_t>(decode_slcan(noisy_decoder, noisy_text.data(), noisy_text.size()));
+    });
+
+    //a symbol at a time: the worst case for the chunk decoder, and what a byte-by-byte serial read loop does
+    servosila::slcan_buffer_decoder symbol_decoder;
+    run_benchmark("process_buffer(), one symbol per call", COUNT, [&symbol_decoder, &text]()
+    {
+        for(size_t i=0; i<text.size(); i++)
+        {
+            symbol_decoder.process_buffer(&(text[i]), 1, [](const servosila::can_message& message)
+            {
+                sink += message.payload[7];
+            });
+        }
+    });
+
+    std::vector<int16_t> float16_values(COUNT);
+    for(size_t i=0; i<COUNT; i++) float16_values[i] = static_cast<int16_t>(next_random());
+    run_benchmark("decode_float16()", COUNT, [&float16_values]()
+    {
+        float sum = 0.0f;
+        for(size_t i=0; i<float16_values.size(); i++) sum += servosila::decode_float16(float16_values[i]);
+        sink += static_cast<uint32_t>(sum != sum);
+    });
+
+    run_benchmark("decode_float16_table()", COUNT, [&float16_values]()
+    {
+        float sum = 0.0f;
+        for(size_t i=0; i<float16_values.size(); i++) sum += servosila::decode_float16_table(float16_values[i]);
+        sink += static_cast<uint32_t>(sum != sum);
+    });
+
+    std::vector<float> float32_values(COUNT);
+    run_benchmark("decode_float16_batch()", COUNT, [&float16_values, &float32_values]()
+    {
+        servosila::decode_float16_batch(float16_values.data(), float32_values.data(), float16_values.size());
+        sink += static_cast<uint32_t>(float32_values[COUNT - 1] != float32_values[COUNT - 1]);
+    });
+
+    run_benchmark("extract_node_id/cob_id_from_can_id()", COUNT, [&messages]()
+    {
+        uint32_t sum = 0;
+        for(size_t i=0; i<messages.size(); i++)
+        {
+            sum += servosila::extract_node_id_from_can_id(messages[i].can_id);
+            sum += servosila::extract_cob_id_from_can_id(messages[i].can_id);
+        }
+        sink += sum;
+    });
+
+    run_benchmark("decode_telemetry()", COUNT, [&messages]()
+    {
+        servosila::node_telemetry decoded = servosila::node_telemetry();   //a message of another type leaves it untouched
+        uint32_t sum = 0;
+        for(size_t i=0; i<messages.size(); i++) sum += servosila::decode_telemetry(messages[i], decoded);
+        sink += sum + static_cast<uint32_t>(decoded.pdo_180.fault_bits);
+    });
+
+    std::vector<servosila::can_message> messages_180(messages);
+    for(size_t i=0; i<COUNT; i++) messages_180[i].can_id = 0x180 + (messages_180[i].can_id & 0x7F);
+    std::vector<servosila::telemetry_180> records_180(COUNT);
+    run_benchmark("decode_pdo<pdo_180_layout>()", COUNT, [&messages_180, &records_180]()
+    {
+        for(size_t i=0; i<messages_180.size(); i++) servosila::decode_pdo<servosila::pdo_180_layout>(messages_180[i].payload, records_180[i]);
+        sink += records_180[COUNT - 1].fault_bits;
+    });
+
+    run_benchmark("decode_pdo_batch<pdo_180_layout>()", COUNT, [&messages_180, &records_180]()
+    {
+        servosila::decode_pdo_batch<servosila::pdo_180_layout>(messages_180.data(), messages_180.size(), records_180.data());
+        sink += records_180[COUNT - 1].fault_bits;
+    });
+
+    run_benchmark("telemetry_store::update()", COUNT, [&messages]()
+    {
+        for(size_t i=0; i<messages.size(); i++) sink += telemetry.update(messages[i], i);
+    });
+
+    //a 1kHz telemetry stream going into a 10 second plot history
+    static servosila::min_max_history history;
+    run_benchmark("min_max_history::add()", COUNT, []()
+    {
+        static uint64_t timestamp_ns = 0;
+        for(size_t i=0; i<COUNT; i++)
+        {
+            timestamp_ns += 1000000;
+            history.add(timestamp_ns, static_cast<float>(i & 0xFF));
+        }
+    });
+
+    //the cost of timing a stage, whatever SERVOSILA_INSTRUMENTATION is set to
+    static servosila::latency_histogram latencies;
+    run_benchmark("latency_histogram::record()", COUNT, []()
+    {
+        static uint64_t value_ns = 0;
+        for(size_t i=0; i<COUNT; i++)
+        {
+            value_ns += 7919;
+            latencies.record(value_ns & 0xFFFFF);
+        }
+    });
+
+    run_benchmark("SLCAN text -> telemetry_store", COUNT, [&decoder, &text]()
+    {
+        for(size_t offset=0; offset<text.size(); offset+=4096)
+        {
+            const size_t block_size = (text.size() - offset < 4096) ? (text.size() - offset) : 4096;
+            decoder.process_buffer(&(text[offset]), block_size, [](const servosila::can_message& message)
+            {
+                sink += telemetry.update(message, 0);
+            });
+        }
+    });
+}
+
+void benchmark_recorded_data(const char* file_name)
+{
+    servosila::mapped_file file;
+    if(!file.open(file_name))
+    {
+        std::cerr<<"Cannot open "<<file_name<<std::endl;
+        return;
+    }
+
+    servosila::frame_log_reader reader;
+    if(reader.attach(file.data(), file.size()))
+    {
+        const size_t count = reader.get_count();
+        std::cout<<"Recorded data: "<<file_name<<", binary frame log, "<<count<<" frames"<<'\n';
+        if(count == 0) return;
+
+        run_benchmark("frame log -> decode_telemetry()", count, [&reader, count]()
+        {
+            servosila::can_message message;
+            servosila::node_telemetry decoded;
+            uint32_t sum = 0;
+            for(size_t i=0; i<count; i++)
+            {
+                servosila::frame_log_reader::to_can_message(reader.get_record(i), message);
+                sum += servosila::decode_telemetry(message, decoded);
+            }
+            sink += sum;
+        });
+
+        //re-encoding the recorded frames as SLCAN text to benchmark the decoder on real traffic
+        std::vector<servosila::can_message> messages(count);
+        for(size_t i=0; i<count; i++) servosila::frame_log_reader::to_can_message(reader.get_record(i), messages[i]);
+        const std::string text = make_slcan_text(messages);
+        servosila::slcan_buffer_decoder decoder;
+        run_benchmark("frame log as SLCAN -> process_buffer()", count, [&decoder, &text]()
+        {
+            sink += static_cast<uint32_t>(decode_slcan(decoder, text.data(), text.size()));
+        });
+    }
+    else
+    {   //raw SLCAN text; the number of frames is learnt from a first pass
+        servosila::slcan_buffer_decoder decoder;
+        const size_t count = decode_slcan(decoder, file.data(), file.size());
+        std::cout<<"Recorded data: "<<file_name<<", SLCAN text, "<<file.size()<<" bytes, "<<count<<" frames"<<'\n';
+        if(count == 0) return;
+
+        run_benchmark("SLCAN capture -> process_buffer()", count, [&decoder, &file]()
+        {
+            sink += static_cast<uint32_t>(decode_slcan(decoder, file.data(), file.size()));
+        });
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    if(!verify_hex_codec())
+    {
+        std::cerr<<"The vectorized hex conversion does not match the scalar one"<<std::endl;
+        return 1;
+    }
+    if(!verify_float16())
+    {
+        std::cerr<<"The batch FLOAT16 conversion does not match decode_float16()"<<std::endl;
+        return 1;
+    }
+    if(!verify_command_scheduler())
+    {
+        std::cerr<<"The command scheduler sends the first commands of several controllers at the same time"<<std::endl;
+        return 1;
+    }
+
+    benchmark_synthetic_data();
+
+    for(int i=1; i<argc; i++)
+    {
+        std::cout<<'\n';
+        benchmark_recorded_data(argv[i]);
+    }
+
+    return 0;
+}
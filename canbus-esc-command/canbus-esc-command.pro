@@ -2,9 +2,18 @@ TEMPLATE = app
 CONFIG += console c++11
 CONFIG -= app_bundle
 CONFIG -= qt
+CONFIG += thread
 
 SOURCES += \
         main.cpp
 
 HEADERS += \
-    ../servosila-common/canbus.h
+    ../servosila-common/can-id-filter.h \
+    ../servosila-common/can-message.h \
+    ../servosila-common/command-scheduler.h \
+    ../servosila-common/commands.h \
+    ../servosila-common/event-loop.h \
+    ../servosila-common/instrumentation.h \
+    ../servosila-common/monotonic-clock.h \
+    ../servosila-common/realtime-loop.h \
+    ../servosila-common/socketcan.h
@@ -1,10 +1,12 @@
 /////////////////////////////////////////////////////////////////////////////
 //
 //  This sample source code comes with Servosila SC-25C Brushless Motor Controllers.
-//  This example sends an Electronic Speed Control (ESC) command in a loop.
+//  This example sends Electronic Speed Control (ESC) commands in a loop to several controllers.
 //      OS: Linux,
 //      Interface: Linux SocketCAN API
 //
+//  Usage: canbus-esc-command [network name, can0 by default; e.g. vcan0 with controller-simulator]
+//
 //  The code is provided "AS IS" without any kind of guarantees or warranties.
 //  Use it at your own risk.
 //
@@ -14,51 +16,79 @@
 //
 /////////////////////////////////////////////////////////////////////////////
 
-#include "../servosila-common/canbus.h" //SocketCAN encapsulation
-#include <string.h>                     //memcpy(), memset()
-#include <stdint.h>                     //standard integer types
-#include <chrono>                       //sleep(), C++11
-#include <thread>                       //sleep(), C++11
+#include "../servosila-common/socketcan.h"          //SocketCAN encapsulation
+#include "../servosila-common/event-loop.h"         //epoll-based main loop
+#include "../servosila-common/command-scheduler.h"  //per-controller command scheduling
+#include "../servosila-common/monotonic-clock.h"    //monotonic_ns()
+#include "../servosila-common/realtime-loop.h"      //SCHED_FIFO cycle with absolute deadlines
+#include <iostream>                                 //console output
+#include <stdint.h>                                 //standard integer types
+#include <chrono>                                   //timer periods, C++11
 
-int main()
+int main(int argc, char* argv[])
 {
+    const char* network_name = (argc > 1) ? argv[1] : "can0";   //check the network name, it could be different in your system
+
     //An object that encapsulates Linux SocketCAN API
     //...An alternative is to use QT's CANbus classes.
-    servosila::canbus canbus;
+    servosila::socketcan canbus;
 
-    //starting up CAN object
-    canbus.startup("can0");     //check the network name, it could be different in your system
+    //starting up SocketCAN encapsulation object
+    canbus.startup(network_name);
 
     if(canbus.is_connected())
     {
-        //a CAN Payload array (8bytes)
-        uint8_t payload[8];
-
-        const uint32_t NODE_ID      = 5;        //this is a unique Node ID of the device. Change this to match your device.
-        const uint32_t COB_ID       = 0x200;    //this value comes from Servosila Device Reference document, section related to "Electronic Speed Control" command
-        const uint8_t  COMMAND_CODE = 0x20;     //this value comes from Servosila Device Reference document, section related to "Electronic Speed Control" command
-        const float    SPEED        = 100.0;    //Hz (electrical), this is a target speed that needs to be sent to the controller. A constant in this example, but normally this is dynamically computed.
+        const uint32_t NODE_IDS[]   = { 5 };    //these are unique Node IDs of the devices. Change this to match your devices; add as many as there are on the CAN network.
+        const float    SPEED        = 100.0;    //Hz (electrical), this is a target speed that needs to be sent to the controllers. A constant in this example, but normally this is dynamically computed.
+        const bool     IS_REALTIME_ENABLED = false;     //a fixed 1ms cycle with SCHED_FIFO priority instead of sleeping in epoll (see realtime-loop.h)
 
-        //Main Loop
-        for(size_t i=0; i<100; i++)     //this should normally be a while(true) loop
+        //The scheduler keeps the latest command of every controller and sends it out at the controller's own rate...
+        //...200ms=5Hz refresh; do not send commands too often as the controller wastes CPU cycles on this, it could otherwise use the cycles to better run the motor.
+        //...a changed command goes out early, but not sooner than 20ms after the previous one.
+        servosila::command_scheduler scheduler;
+        const uint64_t now_ns = servosila::monotonic_ns();
+        for(size_t i=0; i<sizeof(NODE_IDS)/sizeof(NODE_IDS[0]); i++)
         {
-            //zero out all 8 bytes in the payload before filling out with new data
-            memset(&payload, 0, sizeof(payload));
+            scheduler.add_node(NODE_IDS[i], 200000000ull, 20000000ull, now_ns);
+            scheduler.set_command(servosila::make_esc_command(NODE_IDS[i], SPEED));
+        }
+
+        //Main Loop: an event-driven loop that sleeps in epoll until there is something to do
+        servosila::event_loop main_loop;
 
-            //setting Command Code in Payload
-            payload[0] = COMMAND_CODE;          //the very first byte in payload of a command message is the command code.
+        //the scheduler is polled every 10ms; the commands that are due go out in a single system call (sendmmsg)
+        main_loop.add_timer(std::chrono::milliseconds(10), [&canbus, &scheduler]()
+        {
+            //TODO: update the commands here with scheduler.set_command() as the targets change
 
-            //setting Speed parameter in Payload
-            // That the parameter is a FLOAT32 with position 4 comes from Servosila Device Reference document, section related to "Electronic Speed Control" command.
-            memcpy(&(payload[4]), &(SPEED), sizeof(SPEED));
+            servosila::can_message messages[16];
+            const size_t nmessages = scheduler.collect(servosila::monotonic_ns(), messages, 16);
+            if(nmessages > 0) canbus.send_many(messages, nmessages);
+        });
 
-            canbus.send(NODE_ID+COB_ID, &payload, 8);
+        //TODO: read out and process telemetry here (see a different example)
 
-            //TODO: read out and process telemetry here (see a different example)
+        //this example stops after 20 seconds; normally the loop runs until the application exits
+        main_loop.add_timer(std::chrono::seconds(20), [&main_loop]()
+        {
+            main_loop.stop();
+        });
 
-            //this is just a portable way to sleep() in the main loop...
-            //...this method requires C++11
-            std::this_thread::sleep_for(std::chrono::milliseconds(200));    //200ms=5Hz; sending the command 5 times a second; do not send commands too often as the controller wastes CPU cycles on this, it could otherwise use the cycles to better run the motor.
+        //this call returns once main_loop.stop() is called from one of the handlers
+        if(IS_REALTIME_ENABLED)
+        {
+            //the commands go out on the 1ms grid; the settings need privileges, without them the loop still keeps its cycle
+            servosila::realtime_loop realtime;
+            servosila::realtime_config config(1000000ull);     //1ms
+            config.priority = 80;
+            config.cpu      = 1;
+            if(!realtime.setup(config)) std::cerr<<"Real-time settings have not been applied in full"<<std::endl;
+            servosila::run_event_loop(realtime, main_loop);
+            realtime.dump(std::cout);   //the wake-up jitter and the cycle overruns of the session
+        }
+        else
+        {
+            main_loop.run();
         }
 
         //shutting down SocketCAN encapsulation object
@@ -2,10 +2,28 @@ TEMPLATE = app
 CONFIG += console c++11
 CONFIG -= app_bundle
 CONFIG -= qt
+CONFIG += thread
+
+#DEFINES += SERVOSILA_INSTRUMENTATION    # latency histograms and counters of the receive path (see instrumentation.h)
 
 SOURCES += \
         main.cpp
 
 HEADERS += \
-    ../servosila-common/canbus.h \
-    ../servosila-common/canopen-decoder.h
+    ../servosila-common/can-id-filter.h \
+    ../servosila-common/can-message.h \
+    ../servosila-common/event-loop.h \
+    ../servosila-common/fault-supervisor.h \
+    ../servosila-common/liveness-watchdog.h \
+    ../servosila-common/commands.h \
+    ../servosila-common/command-scheduler.h \
+    ../servosila-common/frame-logger.h \
+    ../servosila-common/instrumentation.h \
+    ../servosila-common/monotonic-clock.h \
+    ../servosila-common/realtime-loop.h \
+    ../servosila-common/socketcan.h \
+    ../servosila-common/canopen-decoder.h \
+    ../servosila-common/float16-batch.h \
+    ../servosila-common/telemetry-decoder.h \
+    ../servosila-common/telemetry-pipeline.h \
+    ../servosila-common/telemetry-store.h
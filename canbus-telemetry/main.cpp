@@ -5,6 +5,8 @@
 //      OS: Linux,
 //      Interface: Linux SocketCAN API
 //
+//  Usage: canbus-telemetry [network name, can0 by default; e.g. vcan0 with controller-simulator]
+//
 //  The code is provided "AS IS" without any kind of guarantees or warranties.
 //  Use it at your own risk.
 //
@@ -14,94 +16,265 @@
 //
 ///////////////////////////////////////////////////////////////////////////////////////////////
 
-#include "../servosila-common/canbus.h"             //SocketCAN encapsulation
+#include "../servosila-common/socketcan.h"          //SocketCAN encapsulation
+#include "../servosila-common/event-loop.h"         //epoll-based main loop
 #include "../servosila-common/canopen-decoder.h"    //CANopen helper functions
+#include "../servosila-common/telemetry-store.h"    //latest telemetry of every controller
+#include "../servosila-common/telemetry-pipeline.h" //receiving, logging and decoding of telemetry
+#include "../servosila-common/frame-logger.h"       //binary recording of CAN traffic
+#include "../servosila-common/liveness-watchdog.h"  //silent and drifting controllers
+#include "../servosila-common/fault-supervisor.h"   //STOP and automatic RESET on faults
+#include "../servosila-common/instrumentation.h"    //latency histograms and counters
+#include "../servosila-common/realtime-loop.h"      //SCHED_FIFO cycle with absolute deadlines
 #include <iostream>                                 //console output
 #include <string.h>                                 //memcpy(), memset()
 #include <stdint.h>                                 //standard integer types
-#include <chrono>                                   //sleep(), C++11
-#include <thread>                                   //sleep(), C++11
+#include <signal.h>                                 //sigprocmask()
+#include <sys/signalfd.h>                           //signalfd()
+#include <unistd.h>                                 //read(), close()
+#include <chrono>                                   //timer periods, C++11
+
+//The transport is chosen at compile time...
+//...servosila::slcan_transport (see slcan-telemetry example) and servosila::memory_transport work the same way.
+typedef servosila::socketcan can_transport;
+
+//The latest telemetry of every controller...
+//...other threads (a control loop, a logger, a GUI) may read it at any time with telemetry.read() without locks.
+servosila::telemetry_store telemetry;
+
+//Recording of all received telemetry messages into a binary log file (see frame-logger.h for the format)...
+//...the receive loop only copies frames into memory; a background thread writes them to the disk.
+servosila::frame_logger logger;
+
+//Printing out telemetry as text is slow and cannot keep up with a busy CAN network...
+//...set this to false to record long sessions at full rate; the binary log keeps every frame anyway.
+const bool IS_PRINTING_ENABLED = true;
+
+//Reacting to faults right in the receive path: the faulted controller and its dependent axes get a STOP command...
+//...within microseconds of the fault report; see IS_AUTO_RESET_ENABLED for RESET commands (and fault-supervisor.h).
+servosila::fault_supervisor supervisor;
+
+//A faulted controller stays de-energized until the operator resets it, e.g. with servosila::make_reset_command() (see commands.h).
+//...set this to true to have RESET sent automatically with a growing back-off, but only on a machine where re-energizing
+//...a motor without an operator is safe: the cause of the fault (a jam, an overheated winding) may still be there.
+const bool IS_AUTO_RESET_ENABLED = false;
+
+//Noticing controllers that go quiet, and telemetry periods that drift because of a congested CAN bus...
+//...fed with the arrival times of 0x180 messages; the jitter histograms are printed out with the statistics.
+servosila::liveness_watchdog watchdog;
+
+//Latency histograms of the stages of the receive path and counters of frames, errors and drops...
+//...compiled in with DEFINES += SERVOSILA_INSTRUMENTATION (see the .pro file); dumped every 10 seconds and on SIGUSR1.
+servosila::receive_path_probe probe;
+
+//Real-time mode: the main loop runs on a fixed 1ms cycle with SCHED_FIFO priority, pinned to a CPU, with locked memory...
+//...every cycle drains the transport and runs the timers that are due (see realtime-loop.h);
+//...the wake-up jitter and the cycle overruns are printed out with the statistics.
+const bool IS_REALTIME_ENABLED = false;
+servosila::realtime_loop realtime;
+
+//This routine is called when the telemetry of a controller changes its state (see liveness-watchdog.h)
+void report_liveness(uint32_t node_id, servosila::liveness_state state)
+{
+    static const char* const STATE_NAMES[] = { "unknown", "alive", "drifting", "silent" };
+    std::cout<<"Node ID: "<<node_id<<" telemetry is "<<STATE_NAMES[state]<<'\n';
+}
+
+//This routine is called for every CAN message received, once the message has been logged and decoded...
+//...by the pipeline (see telemetry-pipeline.h); 'COB_ID' is 0 if the message is not telemetry.
+void process_message(can_transport& transport, const servosila::can_message& message, uint32_t COB_ID, uint64_t timestamp_ns)
+{
+    //using helper functions to split CAN ID into NODE ID and COB ID
+    const uint32_t NODE_ID = servosila::extract_node_id_from_can_id(message.can_id);    //this ID tells what of the controllers on CAN network sent the telemetry message
+
+    //applying different processing logic depending on what telemetry message has been received
+    switch(COB_ID)
+    {
+        case 0x180:
+        {
+            //re-arming the deadline of the controller
+            watchdog.on_arrival(NODE_ID, timestamp_ns, report_liveness);
+
+            //reading back the state of the controller the same way any other thread would do
+            servosila::node_snapshot snapshot;
+            telemetry.read(NODE_ID, snapshot);
+
+            const uint16_t fault_bits = snapshot.telemetry.pdo_180.fault_bits;   //Fault Bits (UINT16, position in Payload: 0)
+            const float    Udc        = snapshot.telemetry.pdo_180.Udc;          //Udc voltage (FLOAT16, position in Payload: 2)
+            const float    SPEED      = snapshot.telemetry.pdo_180.speed;        //Speed in Hz, electrical (FLOAT32, position in Payload: 4)
+
+            //printing out the data for demo purposes...
+            //...'\n' rather than std::endl, so that the output is not flushed on every message.
+            if(IS_PRINTING_ENABLED)
+            {
+                std::cout<<"Node ID: "<<NODE_ID<<" Fault Bits: "<<fault_bits<<" "<<Udc<<" V DC Speed: "<<SPEED<<" Hz"<<'\n';
+            }
+
+            //Handiling faults
+            //...the controller keeps the motor de-energized until a "Reset" command comes;
+            //...on a fault edge the STOP commands are sent from here, without waiting for the next timer tick.
+            supervisor.update(NODE_ID, fault_bits, timestamp_ns, [&transport](const servosila::can_message* messages, size_t count)
+            {
+                transport.send_many(messages, count);
+            });
+
+            break;
+        }
+        case 0x280:
+        case 0x380:
+        case 0x480:
+        {
+            //the channels are decoded into snapshot.telemetry.pdo_280, pdo_380 and pdo_480 (see telemetry.read())...
+            //...the formats are defined in Servosila Device Reference document for your device.
+            //TODO: Add other telemetry handlers here
+            break;
+        }
+    }
+}
 
-int main()
+int main(int argc, char* argv[])
 {
+    const char* network_name = (argc > 1) ? argv[1] : "can0";   //check the network name, it could be different in your system
+
+    //Ctrl+C and SIGTERM stop the main loop, so that the frames still in memory are written out to the log;
+    //...kill -USR1 <pid> dumps the instrumentation. The signals are blocked before the log writer thread starts,
+    //...so that they are delivered to the main loop's signalfd.
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    if(servosila::IS_INSTRUMENTATION_ENABLED) sigaddset(&signals, SIGUSR1);
+    sigprocmask(SIG_BLOCK, &signals, nullptr);
+
     //An object that encapsulates Linux SocketCAN API
+    //...the socket descriptor is exposed so that the main loop can wait for incoming frames.
     //...An alternative is to use QT's CANbus classes.
-    servosila::canbus canbus;
+    can_transport transport;
 
     //starting up SocketCAN encapsulation object
-    canbus.startup("can0");     //check the network name, it could be different in your system
+    transport.startup(network_name);
 
-    if(canbus.is_connected())
+    if(transport.is_connected())
     {
-        //Main Loop
-        while(true)
+        //recording all telemetry messages of the session; the frames are appended to the file if it exists
+        logger.open("telemetry.canlog");
+
+        //asking the kernel to deliver telemetry messages only, so that the program does not wake up for unrelated traffic
+        //...add Node IDs to the filter (filter.add_node_id()) to receive telemetry from particular controllers only.
+        servosila::can_id_filter filter;
+        filter.add_cob_id(0x180);
+        filter.add_cob_id(0x280);
+        filter.add_cob_id(0x380);
+        filter.add_cob_id(0x480);
+        transport.set_filter(filter);
+
+        //stamping every frame in the kernel as the CAN driver hands it over, so that the latency of the telemetry
+        //...and the jitter of the controllers are measured without the time the frame waits for the program to wake up...
+        //...use servosila::TIMESTAMP_HARDWARE with CAN controllers that stamp frames as they come off the wire.
+        transport.set_timestamping(servosila::TIMESTAMP_KERNEL);
+
+        //supervising all controllers on the network...
+        //...add dependencies (supervisor.add_dependency(1, 2)) to stop the other axes of a machine when one of them faults.
+        for(uint32_t node_id=1; node_id<=servosila::fault_supervisor::MAX_NODE_ID; node_id++)
         {
-            uint32_t CAN_ID;
-            uint8_t payload[8];
-            uint8_t nbytes_received;
+            supervisor.add_node(node_id, IS_AUTO_RESET_ENABLED);
+        }
 
-            //reading out a CAN frame
-            const bool is_message_received = canbus.receive(&payload, sizeof(payload), nbytes_received, CAN_ID);
+        //Main Loop: an event-driven loop that sleeps in epoll until there is something to do
+        //...the loop wakes up as soon as a CAN frame arrives, so a fault report is seen right away.
+        servosila::event_loop main_loop;
 
-            if(is_message_received)
+        //The receive path: every frame is recorded into the log and decoded into the telemetry table...
+        //...the same code for every transport, resolved at compile time.
+        servosila::telemetry_pipeline<can_transport> pipeline(transport, telemetry);
+        pipeline.set_logger(&logger);
+        pipeline.set_probe(&probe);
+
+        //reading out telemetry as soon as it arrives
+        main_loop.add_reader(transport.get_socket(), [&transport, &pipeline]()
+        {
+            //draining all CAN frames queued in the socket, so that the socket's receive queue never overflows
+            //...the frames are read out in batches, up to 64 frames per system call.
+            pipeline.process([&transport](const servosila::can_message& message, uint32_t cob_id, uint64_t timestamp_ns)
             {
-                //using helper functions to split CAN ID into NODE ID and COB ID
-                const uint32_t NODE_ID = servosila::extract_node_id_from_can_id(CAN_ID);    //this ID tells what of the controllers on CAN network sent the telemetry message
-                const uint32_t COB_ID  = servosila::extract_cob_id_from_can_id (CAN_ID);    //this ID tells how to decode the message (format). Refer to Servosila Device Reference document for telemetry message formats by their COB IDs.
+                process_message(transport, message, cob_id, timestamp_ns);
+            });
+        });
 
-                //applying different decoding logic (format) depending on what telemetry message has been received
-                switch(COB_ID)
-                {
-                    case 0x180:
-                    {
-                        //decoding Fault Bits (UINT16, position in Payload: 0)
-                        uint16_t fault_bits = 0;
-                        memcpy(&fault_bits, &(payload[0]), sizeof(fault_bits));   //extracting INT16
-
-                        //decoding Udc voltage (FLOAT16, position in Payload: 2)
-                        int16_t Udc_float16 = 0;   //ATTENTION: FLOAT16 is transmitted as INT16
-                        memcpy(&Udc_float16, &(payload[2]), sizeof(Udc_float16));
-                        const float Udc = servosila::decode_float16(Udc_float16);   //converting INT16->FLOAT32
-
-                        //decoding Speed in Hz, electrical (FLOAT32, position in Payload: 4)
-                        float SPEED = 0.0;
-                        memcpy(&SPEED, &(payload[4]), sizeof(SPEED)); //extracting FLOAT32
-
-                        //printing out the data for demo purposes
-                        std::cout<<"Node ID: "<<NODE_ID<<" Fault Bits: "<<fault_bits<<" "<<Udc<<" V DC Speed: "<<SPEED<<" Hz"<<std::endl;
-                        std::cout.flush();
-
-                        //Handiling faults
-                        if(fault_bits != 0)
-                        {   //FAULT REPORTED BY THE DEVICE
-                            //...the controller keeps the motor de-energized until a "Reset" command comes.
-                            //TODO: send "Reset" command here once the fault has been rectified...
-                        }
-
-                        break;
-                    }
-                    case 0x280:
-                    case 0x380:
-                    case 0x480:
-                    {
-                        //TODO: Add other telemetry handlers here
-                        //...the formats are defined in Servosila Device Reference document for your device.
-                        //The processing principle is the same as for the 0x180 telemetry message.
-                        break;
-                    }
-                }
+        //a periodic timer for sending out commands to controllers
+        main_loop.add_timer(std::chrono::milliseconds(200), []()
+        {
+            //TODO: send out commands to controllers here (see a different example)
+            //...200ms=5Hz; do not send commands too often as the controller wastes CPU cycles on this.
+        });
+
+        //sending out the automatic RESET commands that are due, and flagging the controllers that went silent
+        main_loop.add_timer(std::chrono::milliseconds(10), [&transport]()
+        {
+            watchdog.advance(servosila::monotonic_ns(), report_liveness);
+            supervisor.poll(servosila::monotonic_ns(), [&transport](const servosila::can_message* messages, size_t count)
+            {
+                transport.send_many(messages, count);
+            });
+        });
+
+        //printing out the telemetry timing and the fault reaction statistics every 10 seconds
+        main_loop.add_timer(std::chrono::seconds(10), []()
+        {
+            for(uint32_t node_id=1; node_id<=servosila::liveness_watchdog::MAX_NODE_ID; node_id++)
+            {
+                const servosila::liveness_stats& timing = watchdog.get_stats(node_id);
+                if(timing.max_interval_ns == 0) continue;   //no intervals since the previous printout
+                std::cout<<"Node ID: "<<node_id<<" period: "<<timing.average_period_ns/1000<<" us jitter p99: "<<watchdog.get_jitter_percentile_ns(node_id, 0.99)/1000
+                         <<" us max interval: "<<timing.max_interval_ns/1000<<" us"<<'\n';
             }
+            watchdog.reset_stats();
+            probe.dump(std::cout);
+            if(IS_REALTIME_ENABLED) realtime.dump(std::cout);
 
-            //TODO: send out commands to controllers here (see a different example)
+            const servosila::fault_reaction_stats& stats = supervisor.get_stats();
+            if(stats.reaction_count == 0) return;
+            std::cout<<"Faults: "<<stats.fault_count<<" resets: "<<stats.reset_count
+                     <<" reaction min/avg/max: "<<stats.reaction_min_ns/1000<<"/"<<stats.reaction_sum_ns/stats.reaction_count/1000
+                     <<"/"<<stats.reaction_max_ns/1000<<" us"<<'\n';
+        });
 
-            //this is just a portable way to sleep() in the main loop...
-            //...this method requires C++11
-            std::this_thread::sleep_for(std::chrono::milliseconds(200));    //200ms=5Hz; reading out telemetry 5 times a second
+        //stopping on Ctrl+C or SIGTERM; dumping the instrumentation on request: kill -USR1 <pid>
+        const int signal_fd = ::signalfd(-1, &signals, SFD_NONBLOCK | SFD_CLOEXEC);
+        if(signal_fd >= 0)
+        {
+            main_loop.add_reader(signal_fd, [signal_fd, &main_loop]()
+            {
+                struct signalfd_siginfo info;
+                while(::read(signal_fd, &info, sizeof(info)) == sizeof(info))
+                {
+                    if(info.ssi_signo == SIGUSR1) probe.dump(std::cout);
+                    else main_loop.stop();
+                }
+            });
+        }
+
+        //this call returns once main_loop.stop() is called from one of the handlers
+        if(IS_REALTIME_ENABLED)
+        {
+            //the settings need privileges (see realtime-loop.h); without them the loop still keeps its cycle
+            servosila::realtime_config config(1000000ull);     //1ms
+            config.priority = 80;
+            config.cpu      = 1;
+            if(!realtime.setup(config)) std::cerr<<"Real-time settings have not been applied in full"<<std::endl;
+            servosila::run_event_loop(realtime, main_loop);
+        }
+        else
+        {
+            main_loop.run();
+        }
 
-        } //while() of the main loop
+        //writing out the frames still in memory and closing the log file
+        logger.close();
+        if(signal_fd >= 0) ::close(signal_fd);
 
         //shutting down SocketCAN encapsulation object
-        canbus.shutdown();
+        transport.shutdown();
     }
 
     return 0;
@@ -0,0 +1,26 @@
+TEMPLATE = app
+CONFIG += console c++11
+CONFIG -= app_bundle
+CONFIG -= qt
+
+SOURCES += \
+        main.cpp
+
+HEADERS += \
+    ../servosila-common/can-id-filter.h \
+    ../servosila-common/can-message.h \
+    ../servosila-common/commands.h \
+    ../servosila-common/controller-simulator.h \
+    ../servosila-common/event-loop.h \
+    ../servosila-common/hex-codec.h \
+    ../servosila-common/instrumentation.h \
+    ../servosila-common/monotonic-clock.h \
+    ../servosila-common/serial-port.h \
+    ../servosila-common/slcan-buffer-decoder.h \
+    ../servosila-common/slcan-command-builder.h \
+    ../servosila-common/slcan-message-encoder.h \
+    ../servosila-common/slcan-transport.h \
+    ../servosila-common/socketcan.h
+
+DISTFILES += \
+    faults.scenario
@@ -0,0 +1,246 @@
+///////////////////////////////////////////////////////////////////////////////////////////////
+//
+//  This sample source code comes with Servosila SC-25C Brushless Motor Controllers.
+//
+//  This example impersonates a fleet of SC-25 controllers, so that the other examples can be
+//  tested and load-tested without hardware: the simulated controllers stream 0x180..0x480 telemetry
+//  and obey ESC, STOP and RESET commands; a scenario file replays faults at fixed times.
+//      OS: Linux,
+//      Interface: Linux SocketCAN API on a virtual CAN network, or SLCAN on a pseudo-terminal
+//
+//  Usage: controller-simulator [network name or "pty", vcan0 by default] [number of controllers, 4 by default]
+//                              [messages per second of every telemetry message, 100 by default] [scenario file]
+//      a virtual CAN network is created with:
+//          sudo modprobe vcan && sudo ip link add dev vcan0 type vcan && sudo ip link set up vcan0
+//      with "pty", the SLCAN examples open the printed device (e.g. /dev/pts/3) instead of /dev/ttyACM0.
+//      A line of a scenario file is an event: "<seconds> fault <Node ID> <Fault Bits>",
+//      "<seconds> silence <Node ID> <seconds>" or "<seconds> drift <Node ID> <period, parts per million>".
+//      See faults.scenario. Ctrl+C stops the simulator.
+//
+//  The code is provided "AS IS" without any kind of guarantees or warranties.
+//  Use it at your own risk.
+//
+//  The code is free for everyone to use, modify or redistribute.
+//
+//  www.servosila.com
+//
+///////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "../servosila-common/socketcan.h"              //SocketCAN encapsulation
+#include "../servosila-common/slcan-transport.h"        //SLCAN over a pseudo-terminal
+#include "../servosila-common/event-loop.h"             //epoll-based main loop
+#include "../servosila-common/controller-simulator.h"   //simulated controllers
+#include "../servosila-common/monotonic-clock.h"        //monotonic_ns()
+#include <iostream>                                     //console output
+#include <fstream>                                      //scenario file
+#include <sstream>                                      //parsing of scenario lines
+#include <string>                                       //std::string
+#include <stdint.h>                                     //standard integer types
+#include <stdlib.h>                                     //atoi(), atof()
+#include <string.h>                                     //strcmp()
+#include <signal.h>                                     //sigprocmask()
+#include <sys/signalfd.h>                               //signalfd()
+#include <unistd.h>                                     //read(), close()
+#include <chrono>                                       //timer periods, C++11
+
+//Converts seconds of a scenario into nanoseconds; returns false for a negative time, or one beyond about 580 years,
+//...which would wrap around in the conversion
+bool seconds_to_ns(double seconds, uint64_t& ns)
+{
+    if(!(seconds >= 0 && seconds < 1.8e10)) return false;
+    ns = static_cast<uint64_t>(seconds * 1e9);
+    return true;
+}
+
+//Reads a scenario file into the simulator; returns false if the file cannot be read or has a malformed line
+bool load_scenario(const char* file_name, servosila::controller_simulator& simulator)
+{
+    std::ifstream file(file_name);
+    if(!file) return false;
+
+    std::string line;
+    size_t line_number = 0;
+    while(std::getline(file, line))
+    {
+        line_number++;
+        if(line.empty() || line[0] == '#') continue;
+
+        std::istringstream fields(line);
+        double seconds = 0;
+        std::string type;
+        uint32_t node_id = 0;
+        double value = 0;
+        //the times and the values are converted to unsigned integers below: a negative number would wrap around
+        servosila::simulation_event event;
+        if(!(fields >> seconds >> type >> node_id >> value) || !seconds_to_ns(seconds, event.at_ns) || !(value >= 0))
+        {
+            std::cerr<<file_name<<":"<<line_number<<": malformed event"<<std::endl;
+            return false;
+        }
+
+        event.node_id     = node_id;
+        event.fault_bits  = 0;
+        event.duration_ns = 0;
+        event.period_ppm  = servosila::controller_simulator::NOMINAL_PPM;
+        if(type == "fault")
+        {
+            if(value > 0xFFFF)
+            {
+                std::cerr<<file_name<<":"<<line_number<<": Fault Bits out of range"<<std::endl;
+                return false;
+            }
+            event.type       = servosila::SIMULATION_FAULT;
+            event.fault_bits = static_cast<uint16_t>(value);
+        }
+        else if(type == "silence")
+        {
+            if(!seconds_to_ns(value, event.duration_ns))
+            {
+                std::cerr<<file_name<<":"<<line_number<<": duration out of range"<<std::endl;
+                return false;
+            }
+            event.type        = servosila::SIMULATION_SILENCE;
+        }
+        else if(type == "drift")
+        {
+            if(value > 0xFFFFFFFF)
+            {
+                std::cerr<<file_name<<":"<<line_number<<": period out of range"<<std::endl;
+                return false;
+            }
+            event.type       = servosila::SIMULATION_DRIFT;
+            event.period_ppm = static_cast<uint32_t>(value);
+        }
+        else
+        {
+            std::cerr<<file_name<<":"<<line_number<<": unknown event "<<type<<std::endl;
+            return false;
+        }
+        if(!simulator.add_event(event))
+        {
+            std::cerr<<file_name<<":"<<line_number<<": too many events"<<std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+//The simulation is the same for every transport; the transport is resolved at compile time
+template<typename Transport>
+void run_simulation(Transport& transport, servosila::controller_simulator& simulator, int signal_fd)
+{
+    //Main Loop: an event-driven loop that sleeps in epoll until there is something to do
+    servosila::event_loop main_loop;
+
+    //the commands are obeyed as soon as they arrive, as the real controllers do
+    main_loop.add_reader(transport.get_socket(), [&transport, &simulator]()
+    {
+        servosila::can_message messages[64];
+        while(true)
+        {
+            const size_t nmessages = transport.receive_many(messages, 64);
+            for(size_t i=0; i<nmessages; i++) simulator.handle_command(messages[i]);
+            if(nmessages < 64) break;   //the transport has been drained
+        }
+    });
+
+    //the telemetry is sent every millisecond; faster rates are sent as several messages per tick...
+    //...the simulator never waits for room in the transport: the frames that do not fit are counted as dropped,
+    //...e.g. while no application reads the pseudo-terminal, as a real adapter drops frames nobody takes.
+    simulator.start(servosila::monotonic_ns());
+    main_loop.add_timer(std::chrono::milliseconds(1), [&transport, &simulator]()
+    {
+        simulator.poll(servosila::monotonic_ns(), [&transport](const servosila::can_message* messages, size_t count)
+        {
+            return transport.try_send_many(messages, count);
+        });
+    });
+
+    //a status line every 10 seconds
+    main_loop.add_timer(std::chrono::seconds(10), [&simulator]()
+    {
+        const servosila::simulation_stats& stats = simulator.get_stats();
+        std::cout<<"Frames sent: "<<stats.frames_sent<<" dropped: "<<stats.frames_dropped
+                 <<" ESC: "<<stats.esc_count<<" STOP: "<<stats.stop_count<<" RESET: "<<stats.reset_count
+                 <<" unknown: "<<stats.unknown_count<<" events: "<<stats.event_count<<'\n'<<std::flush;
+    });
+
+    if(signal_fd >= 0)
+    {
+        main_loop.add_reader(signal_fd, [signal_fd, &main_loop]()
+        {
+            struct signalfd_siginfo info;
+            if(::read(signal_fd, &info, sizeof(info)) == sizeof(info)) main_loop.stop();
+        });
+    }
+
+    //this call returns once main_loop.stop() is called from one of the handlers
+    main_loop.run();
+}
+
+int main(int argc, char* argv[])
+{
+    const char*    network_name = (argc > 1) ? argv[1] : "vcan0";
+    const int      node_count   = (argc > 2) ? atoi(argv[2]) : 4;
+    const double   rate         = (argc > 3) ? atof(argv[3]) : 100.0;
+    const char*    scenario     = (argc > 4) ? argv[4] : nullptr;
+
+    if(node_count < 1 || node_count > static_cast<int>(servosila::controller_simulator::MAX_NODE_ID) || rate <= 0)
+    {
+        std::cerr<<"Usage: controller-simulator [network name or pty] [number of controllers] [messages per second] [scenario file]"<<std::endl;
+        return 1;
+    }
+
+    //the controllers get Node IDs 1..node_count; all four telemetry messages are sent at the same rate
+    servosila::controller_simulator simulator;
+    for(int node_id=1; node_id<=node_count; node_id++) simulator.add_node(static_cast<uint32_t>(node_id));
+    const uint64_t period_ns = static_cast<uint64_t>(1e9 / rate);
+    simulator.set_period(0x180, period_ns);
+    simulator.set_period(0x280, period_ns);
+    simulator.set_period(0x380, period_ns);
+    simulator.set_period(0x480, period_ns);
+
+    if(scenario != nullptr && !load_scenario(scenario, simulator)) return 1;
+
+    //SIGINT and SIGTERM are delivered through a descriptor, so that the simulator stops from the main loop and cleans up
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    sigprocmask(SIG_BLOCK, &signals, nullptr);
+    const int signal_fd = ::signalfd(-1, &signals, SFD_NONBLOCK | SFD_CLOEXEC);
+
+    if(strcmp(network_name, "pty") == 0)
+    {
+        //the simulator plays the USB-CAN adapter on the master side of a pseudo-terminal
+        servosila::slcan_transport transport;
+        if(!transport.startup_pseudo_terminal())
+        {
+            std::cerr<<"Cannot create a pseudo-terminal"<<std::endl;
+            return 1;
+        }
+        std::cout<<"Simulating "<<node_count<<" controllers on "<<transport.get_port().get_peer_name()<<'\n'<<std::flush;
+        run_simulation(transport, simulator, signal_fd);
+        transport.shutdown();
+    }
+    else
+    {
+        servosila::socketcan transport;
+        if(!transport.startup(network_name))
+        {
+            std::cerr<<"Cannot open CAN network "<<network_name<<std::endl;
+            return 1;
+        }
+        //only the commands are received, not the telemetry of other simulators or real controllers on the same network
+        servosila::can_id_filter filter;
+        filter.add_cob_id(servosila::COMMAND_COB_ID);
+        transport.set_filter(filter);
+
+        std::cout<<"Simulating "<<node_count<<" controllers on "<<network_name<<'\n'<<std::flush;
+        run_simulation(transport, simulator, signal_fd);
+        transport.shutdown();
+    }
+
+    if(signal_fd >= 0) ::close(signal_fd);
+    return 0;
+}
@@ -0,0 +1,100 @@
+/////////////////////////////////////////////////////////////////////////////
+//
+//  This source code comes with Servosila SC-25C Brushless Motor Controllers.
+//  A set of Node IDs and COB IDs the application is interested in.
+//
+//  The code is provided "AS IS" without any kind of guarantees or warranties.
+//  Use it at your own risk.
+//
+//  The code is free for everyone to use, modify or redistribute.
+//
+//  www.servosila.com
+//
+/////////////////////////////////////////////////////////////////////////////
+
+#ifndef SERVOSILA_CAN_ID_FILTER_H
+#define SERVOSILA_CAN_ID_FILTER_H
+
+#include <stdint.h>     //standard integer types
+
+namespace servosila
+{
+
+//A filter of 11-bit CAN IDs built as a product of Node IDs and COB IDs.
+//...A CANopen CAN ID is COB ID + Node ID, where Node ID is 1..127 (the lower 7 bits)
+//...and COB ID is a multiple of 0x80 (the upper 4 bits), e.g. 0x180 for the first telemetry message.
+//If no Node IDs are added, messages from all nodes are accepted; the same applies to COB IDs.
+//The check is a couple of bit tests, so it is cheap enough to be done before the payload is decoded.
+class can_id_filter
+{
+public:
+    can_id_filter()
+    {
+        clear();
+    }
+
+    //accept messages sent by this node (1..127)
+    void add_node_id(uint32_t node_id)
+    {
+        node_id &= 0x7F;
+        m_node_mask[node_id >> 6] |= (uint64_t(1) << (node_id & 63));
+        m_is_node_filter_set = true;
+    }
+
+    //accept messages of this type, e.g. 0x180, 0x280, 0x380, 0x480 for telemetry
+    void add_cob_id(uint32_t cob_id)
+    {
+        m_cob_mask |= static_cast<uint16_t>(1u << ((cob_id >> 7) & 0x0F));
+        m_is_cob_filter_set = true;
+    }
+
+    //accept everything
+    void clear()
+    {
+        m_node_mask[0] = 0;
+        m_node_mask[1] = 0;
+        m_cob_mask = 0;
+        m_is_node_filter_set = false;
+        m_is_cob_filter_set  = false;
+    }
+
+    bool is_empty() const
+    {
+        return !m_is_node_filter_set && !m_is_cob_filter_set;
+    }
+
+    bool accepts(uint32_t can_id) const
+    {
+        if(is_empty()) return true;
+        if(can_id > 0x7FF) return false;    //only 11-bit CANopen IDs are filtered by Node ID and COB ID
+
+        const uint32_t node_id = can_id & 0x7F;
+        const uint32_t cob_index = can_id >> 7;
+        if(m_is_node_filter_set && !(m_node_mask[node_id >> 6] & (uint64_t(1) << (node_id & 63)))) return false;
+        if(m_is_cob_filter_set  && !(m_cob_mask & (1u << cob_index))) return false;
+        return true;
+    }
+
+    bool accepts_node_id(uint32_t node_id) const
+    {
+        return !m_is_node_filter_set || ((node_id <= 0x7F) && (m_node_mask[node_id >> 6] & (uint64_t(1) << (node_id & 63))));
+    }
+
+    bool accepts_cob_id(uint32_t cob_id) const
+    {
+        return !m_is_cob_filter_set || ((cob_id <= 0x780) && (m_cob_mask & (1u << (cob_id >> 7))));
+    }
+
+    bool is_node_filter_set() const { return m_is_node_filter_set; }
+    bool is_cob_filter_set()  const { return m_is_cob_filter_set;  }
+
+private:
+    uint64_t m_node_mask[2];    //one bit per Node ID 0..127
+    uint16_t m_cob_mask;        //one bit per COB ID 0x000..0x780
+    bool     m_is_node_filter_set;
+    bool     m_is_cob_filter_set;
+};
+
+} //namespace servosila
+
+#endif // SERVOSILA_CAN_ID_FILTER_H
@@ -0,0 +1,42 @@
+/////////////////////////////////////////////////////////////////////////////
+//
+//  This source code comes with Servosila SC-25C Brushless Motor Controllers.
+//  A plain CAN message structure shared by the decoders and the transports.
+//
+//  The code is provided "AS IS" without any kind of guarantees or warranties.
+//  Use it at your own risk.
+//
+//  The code is free for everyone to use, modify or redistribute.
+//
+//  www.servosila.com
+//
+/////////////////////////////////////////////////////////////////////////////
+
+#ifndef SERVOSILA_CAN_MESSAGE_H
+#define SERVOSILA_CAN_MESSAGE_H
+
+#include <stdint.h>     //standard integer types
+
+namespace servosila
+{
+
+//A single CAN message (frame) as it is passed between transports, decoders and the application.
+struct can_message
+{
+    uint32_t can_id;        //11-bit or 29-bit CAN ID; use extract_node_id_from_can_id() and extract_cob_id_from_can_id() to split it
+    uint8_t  length;        //number of payload bytes, 0..8
+    uint8_t  payload[8];    //payload bytes; the bytes beyond 'length' are zeroed
+};
+
+//Where the time of arrival of a received frame comes from; the times are in monotonic_ns() time base in all cases.
+//...see socketcan::set_timestamping(); the other transports only have TIMESTAMP_RECEIVE.
+enum rx_timestamp_source
+{
+    TIMESTAMP_RECEIVE   = 0,    //the application received the frame: the return of the system call
+    TIMESTAMP_KERNEL    = 1,    //the kernel received the frame from the CAN driver (SO_TIMESTAMPING, software)
+    TIMESTAMP_HARDWARE  = 2     //the CAN controller received the frame, if the driver supports it (SO_TIMESTAMPING, hardware)
+};
+
+} //namespace servosila
+
+#endif // SERVOSILA_CAN_MESSAGE_H
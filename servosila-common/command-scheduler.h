@@ -0,0 +1,180 @@
+/////////////////////////////////////////////////////////////////////////////
+//
+//  This source code comes with Servosila SC-25C Brushless Motor Controllers.
+//  A scheduler of periodic commands to many controllers on one CAN network.
+//
+//  The code is provided "AS IS" without any kind of guarantees or warranties.
+//  Use it at your own risk.
+//
+//  The code is free for everyone to use, modify or redistribute.
+//
+//  www.servosila.com
+//
+/////////////////////////////////////////////////////////////////////////////
+
+#ifndef SERVOSILA_COMMAND_SCHEDULER_H
+#define SERVOSILA_COMMAND_SCHEDULER_H
+
+#include "can-message.h"
+#include "commands.h"     //make_esc_command()
+#include <stddef.h>     //size_t
+#include <stdint.h>     //standard integer types
+#include <string.h>     //memcpy(), memset()
+
+namespace servosila
+{
+
+//The scheduler keeps the latest command for every controller and decides when each one goes out:
+//...- a command is repeated every 'refresh period' of its controller, even if it has not changed;
+//...- a new command goes out early, but never sooner than the 'minimal interval' after the previous one,
+//...  so that the controller's CPU is not wasted on a flood of commands (the latest command wins, the rest are coalesced);
+//...- the first transmissions of the controllers are staggered across the refresh period, and at most 'max burst'
+//...  commands go out per call of collect(), so that a dozen controllers do not load the bus at the same instant.
+//The application updates commands with set_command() at any rate and calls collect() from a periodic timer
+//...that is a few times faster than the shortest refresh period, e.g. every 10ms.
+//ATTENTION: the scheduler is not thread-safe; call it from the thread that owns the CAN transport.
+class command_scheduler
+{
+public:
+    static const uint32_t MAX_NODE_ID = 127;
+    static const uint32_t PHASE_COUNT = 128;     //phases of the refresh period the first transmissions are spread over
+
+    explicit command_scheduler(size_t max_burst = 4) : m_max_burst(max_burst), m_node_count(0), m_added_count(0), m_cursor(0)
+    {
+        memset(m_nodes, 0, sizeof(m_nodes));
+    }
+
+    //starts commanding a controller; 'now_ns' is monotonic_ns() time
+    //...e.g. refresh_period_ns = 200ms (5Hz) and min_interval_ns = 20ms.
+    bool add_node(uint32_t node_id, uint64_t refresh_period_ns, uint64_t min_interval_ns, uint64_t now_ns)
+    {
+        if(node_id == 0 || node_id > MAX_NODE_ID || refresh_period_ns == 0) return false;
+
+        node& n = m_nodes[node_id];
+        if(!n.is_active)
+        {   //staggering: the controllers get phases of the refresh period in the order they are added...
+            //...bit-reversed, so that every next controller halves the largest gap: 0, 1/2, 1/4, 3/4, 1/8...
+            //...up to 128 controllers never share a phase, whatever their Node IDs.
+            n.phase = reverse_phase_bits(m_added_count++ % PHASE_COUNT);
+            m_node_count++;
+        }
+        n.is_active         = true;
+        n.has_command       = false;
+        n.is_updated        = false;
+        n.refresh_period_ns = refresh_period_ns;
+        n.min_interval_ns   = (min_interval_ns < refresh_period_ns) ? min_interval_ns : refresh_period_ns;
+        n.next_refresh_ns   = now_ns + refresh_period_ns * n.phase / PHASE_COUNT;
+        n.earliest_ns       = now_ns;
+        return true;
+    }
+
+    //stops commanding a controller; the last command is not sent again
+    void remove_node(uint32_t node_id)
+    {
+        if(node_id > MAX_NODE_ID || !m_nodes[node_id].is_active) return;
+        m_nodes[node_id].is_active = false;
+        m_node_count--;
+    }
+
+    //replaces the command of a controller; the Node ID is taken from the CAN ID of the message...
+    //...returns false if the controller has not been added.
+    bool set_command(const can_message& message)
+    {
+        const uint32_t node_id = message.can_id & 0x7F;
+        if(message.can_id > 0x7FF || !m_nodes[node_id].is_active) return false;
+
+        node& n = m_nodes[node_id];
+        n.message     = message;
+        n.is_updated  = n.has_command;  //the very first command waits for the node's staggered phase
+        n.has_command = true;
+        return true;
+    }
+
+    //drops the command of a controller, e.g. after a STOP command has been sent to it directly
+    void clear_command(uint32_t node_id)
+    {
+        if(node_id > MAX_NODE_ID) return;
+        m_nodes[node_id].has_command = false;
+        m_nodes[node_id].is_updated  = false;
+    }
+
+    //Copies up to 'count' commands that are due at 'now_ns' to 'messages', ready for socketcan::send_many()
+    //...or for SLCAN encoding; returns the number of commands copied. The controllers are served round-robin,
+    //...so that a controller with a low Node ID does not always go first when the burst limit is hit.
+    size_t collect(uint64_t now_ns, can_message* messages, size_t count)
+    {
+        const size_t limit = (count < m_max_burst) ? count : m_max_burst;
+        size_t ncollected = 0;
+
+        for(uint32_t i=0; i<MAX_NODE_ID && ncollected<limit; i++)
+        {
+            const uint32_t node_id = (m_cursor + i) % MAX_NODE_ID + 1;     //1..127
+            node& n = m_nodes[node_id];
+            if(!n.is_active || !n.has_command) continue;
+
+            const bool is_refresh_due = (now_ns >= n.next_refresh_ns);
+            const bool is_update_due  = n.is_updated && (now_ns >= n.earliest_ns);
+            if(!is_refresh_due && !is_update_due) continue;
+
+            messages[ncollected++] = n.message;
+            n.is_updated      = false;
+            n.earliest_ns     = now_ns + n.min_interval_ns;
+            //keeping the phase of the controller if it is on time; re-phasing if it has fallen behind (e.g. after a burst limit)
+            n.next_refresh_ns = (is_refresh_due && now_ns - n.next_refresh_ns < n.refresh_period_ns)
+                              ? n.next_refresh_ns + n.refresh_period_ns
+                              : now_ns + n.refresh_period_ns;
+            m_cursor = node_id % MAX_NODE_ID;
+        }
+        return ncollected;
+    }
+
+    size_t get_node_count() const
+    {
+        return m_node_count;
+    }
+
+    //the phase of a controller's first transmission, in 1/PHASE_COUNT of its refresh period; 0 if it has not been added
+    uint32_t get_phase(uint32_t node_id) const
+    {
+        return (node_id <= MAX_NODE_ID && m_nodes[node_id].is_active) ? m_nodes[node_id].phase : 0;
+    }
+
+private:
+    struct node
+    {
+        can_message message;            //the latest command
+        uint64_t    next_refresh_ns;    //when the command is to be repeated
+        uint64_t    earliest_ns;        //the earliest time the next command may go out (the rate limit)
+        uint64_t    refresh_period_ns;
+        uint64_t    min_interval_ns;
+        uint32_t    phase;              //see get_phase()
+        bool        is_active;
+        bool        has_command;
+        bool        is_updated;         //a new command has been set since the previous transmission
+    };
+
+    node     m_nodes[MAX_NODE_ID + 1];
+    size_t   m_max_burst;
+    size_t   m_node_count;
+    uint32_t m_added_count;             //controllers added so far; hands out the phases
+    uint32_t m_cursor;                  //where the next round-robin pass starts, 0..126
+
+    //reverses the 7 bits of a phase index
+    static uint32_t reverse_phase_bits(uint32_t index)
+    {
+        uint32_t phase = 0;
+        for(uint32_t bit=1; bit<PHASE_COUNT; bit<<=1)
+        {
+            phase <<= 1;
+            if(index & bit) phase |= 1;
+        }
+        return phase;
+    }
+
+    command_scheduler(const command_scheduler&);            //non-copyable
+    command_scheduler& operator=(const command_scheduler&);
+};
+
+} //namespace servosila
+
+#endif // SERVOSILA_COMMAND_SCHEDULER_H
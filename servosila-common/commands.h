@@ -0,0 +1,64 @@
+/////////////////////////////////////////////////////////////////////////////
+//
+//  This source code comes with Servosila SC-25C Brushless Motor Controllers.
+//  Builders of the command messages sent to controllers.
+//
+//  The code is provided "AS IS" without any kind of guarantees or warranties.
+//  Use it at your own risk.
+//
+//  The code is free for everyone to use, modify or redistribute.
+//
+//  www.servosila.com
+//
+/////////////////////////////////////////////////////////////////////////////
+
+#ifndef SERVOSILA_COMMANDS_H
+#define SERVOSILA_COMMANDS_H
+
+#include "can-message.h"
+#include <stdint.h>     //standard integer types
+#include <string.h>     //memcpy(), memset()
+
+namespace servosila
+{
+
+//these values come from Servosila Device Reference document
+static const uint32_t COMMAND_COB_ID     = 0x200;   //commands are sent with COB ID 0x200 + Node ID
+static const uint8_t  COMMAND_CODE_RESET = 0x01;    //clears Fault Bits latches, powers off the motor
+static const uint8_t  COMMAND_CODE_STOP  = 0x04;    //stops the motor
+static const uint8_t  COMMAND_CODE_ESC   = 0x20;    //Electronic Speed Control, FLOAT32 speed (Hz, electrical) at position 4
+
+//Builds a command message without parameters: the very first byte in payload of a command message is the command code.
+inline can_message make_command(uint32_t node_id, uint8_t command_code)
+{
+    can_message message;
+    message.can_id = COMMAND_COB_ID + node_id;
+    message.length = 8;
+    memset(message.payload, 0, sizeof(message.payload));
+    message.payload[0] = command_code;
+    return message;
+}
+
+//Builds an Electronic Speed Control command.
+inline can_message make_esc_command(uint32_t node_id, float speed)
+{
+    can_message message = make_command(node_id, COMMAND_CODE_ESC);
+    memcpy(&(message.payload[4]), &speed, sizeof(speed));
+    return message;
+}
+
+//Builds a STOP command.
+inline can_message make_stop_command(uint32_t node_id)
+{
+    return make_command(node_id, COMMAND_CODE_STOP);
+}
+
+//Builds a RESET command.
+inline can_message make_reset_command(uint32_t node_id)
+{
+    return make_command(node_id, COMMAND_CODE_RESET);
+}
+
+} //namespace servosila
+
+#endif // SERVOSILA_COMMANDS_H
@@ -0,0 +1,405 @@
+/////////////////////////////////////////////////////////////////////////////
+//
+//  This source code comes with Servosila SC-25C Brushless Motor Controllers.
+//  A simulated fleet of SC-25 controllers for testing the telemetry and
+//  command paths without hardware.
+//
+//  The code is provided "AS IS" without any kind of guarantees or warranties.
+//  Use it at your own risk.
+//
+//  The code is free for everyone to use, modify or redistribute.
+//
+//  www.servosila.com
+//
+/////////////////////////////////////////////////////////////////////////////
+
+#ifndef SERVOSILA_CONTROLLER_SIMULATOR_H
+#define SERVOSILA_CONTROLLER_SIMULATOR_H
+
+#include "can-message.h"
+#include "commands.h"           //COMMAND_COB_ID, COMMAND_CODE_* values
+#include <stddef.h>             //size_t
+#include <stdint.h>             //standard integer types
+#include <string.h>             //memcpy(), memset()
+
+namespace servosila
+{
+
+//What happens to a simulated controller at a given time of a scenario
+enum simulation_event_type
+{
+    SIMULATION_FAULT,       //Fault Bits are latched; the motor is de-energized until a RESET command
+    SIMULATION_SILENCE,     //the controller stops transmitting telemetry for 'duration_ns'
+    SIMULATION_DRIFT        //the telemetry periods of the controller change by 'period_ppm' (parts per million)
+};
+
+struct simulation_event
+{
+    uint64_t              at_ns;            //since start()
+    uint32_t              node_id;
+    simulation_event_type type;
+    uint16_t              fault_bits;       //SIMULATION_FAULT
+    uint64_t              duration_ns;      //SIMULATION_SILENCE
+    uint32_t              period_ppm;       //SIMULATION_DRIFT, e.g. 1050000 for periods 5% longer than nominal
+};
+
+struct simulation_stats
+{
+    uint64_t frames_sent;       //telemetry frames accepted by the transport
+    uint64_t frames_dropped;    //telemetry frames the transport had no room for
+    uint64_t esc_count;         //commands received, by command code
+    uint64_t stop_count;
+    uint64_t reset_count;
+    uint64_t unknown_count;     //commands with other codes, or to Node IDs that are not simulated
+    uint64_t event_count;       //scenario events applied
+};
+
+//Impersonates up to 127 SC-25 controllers on a CAN transport:
+//...- every controller streams 0x180, 0x280, 0x380 and 0x480 telemetry at its own rate; the controllers transmit
+//...  at evenly spread phases, the way independent controllers would, rather than all at once;
+//...- ESC (0x20) commands ramp the speed towards the commanded one, STOP (0x04) ramps it down to zero,
+//...  RESET (0x01) clears Fault Bits and powers the motor off; ESC commands are ignored while Fault Bits are set;
+//...- a scenario of faults, silences and drifting periods is played at fixed times since start(), so every run
+//...  of a test sees the same sequence of events.
+//0x180 telemetry is encoded as the real controllers do it (see telemetry-decoder.h); the payload of 0x280, 0x380 and 0x480
+//...is four INT16 channels: a sequence counter of the message (to detect lost frames), Node ID, speed (Hz) and Fault Bits.
+//'Send' is any callable 'size_t(const can_message* messages, size_t count)' that returns the number of frames accepted,
+//...e.g. a lambda around socketcan::send_many().
+//ATTENTION: the simulator is not thread-safe; call it from one thread.
+class controller_simulator
+{
+public:
+    static const uint32_t MAX_NODE_ID    = 127;
+    static const size_t   PDO_COUNT      = 4;       //0x180, 0x280, 0x380, 0x480
+    static const size_t   MAX_EVENTS     = 256;
+    static const uint32_t NOMINAL_PPM    = 1000000;
+    static const uint64_t MAX_LAG_NS     = 100000000ull;    //100ms; a simulator that has fallen further behind skips the frames
+
+    controller_simulator()
+        : m_event_count(0), m_next_event(0), m_start_ns(0), m_previous_poll_ns(0),
+          m_acceleration(500.0f),   //Hz per second
+          m_voltage(48.0f)          //V DC
+    {
+        memset(m_nodes, 0, sizeof(m_nodes));
+        for(size_t i=0; i<PDO_COUNT; i++) m_periods_ns[i] = 10000000ull;    //10ms, 100 messages per second
+        reset_stats();
+    }
+
+    //starts simulating a controller
+    bool add_node(uint32_t node_id)
+    {
+        if(node_id == 0 || node_id > MAX_NODE_ID) return false;
+        node& n = m_nodes[node_id];
+        n.is_simulated = true;
+        n.period_ppm   = NOMINAL_PPM;
+        return true;
+    }
+
+    //the period of a telemetry message, e.g. set_period(0x280, 1000000) for 1000 messages per second; 0 turns it off...
+    //...call it before start().
+    bool set_period(uint32_t cob_id, uint64_t period_ns)
+    {
+        const size_t pdo = get_pdo_index(cob_id);
+        if(pdo >= PDO_COUNT) return false;
+        m_periods_ns[pdo] = period_ns;
+        return true;
+    }
+
+    //how fast the simulated motors follow the commanded speed, Hz per second
+    void set_acceleration(float acceleration)
+    {
+        m_acceleration = acceleration;
+    }
+
+    //the DC voltage reported in 0x180 telemetry
+    void set_voltage(float voltage)
+    {
+        m_voltage = voltage;
+    }
+
+    //adds an event to the scenario; the events may be added in any order. Returns false if the scenario is full.
+    bool add_event(const simulation_event& event)
+    {
+        if(m_event_count >= MAX_EVENTS || event.node_id > MAX_NODE_ID) return false;
+        size_t position = m_event_count++;
+        while(position > 0 && m_events[position - 1].at_ns > event.at_ns)
+        {
+            m_events[position] = m_events[position - 1];
+            position--;
+        }
+        m_events[position] = event;
+        return true;
+    }
+
+    //starts the telemetry and the scenario clock
+    void start(uint64_t now_ns)
+    {
+        m_start_ns         = now_ns;
+        m_previous_poll_ns = now_ns;
+        m_next_event       = 0;
+        for(uint32_t node_id=1; node_id<=MAX_NODE_ID; node_id++)
+        {
+            node& n = m_nodes[node_id];
+            if(!n.is_simulated) continue;
+            for(size_t pdo=0; pdo<PDO_COUNT; pdo++)
+            {   //the phase of a controller within the period depends on its Node ID only
+                n.next_ns[pdo] = now_ns + get_period_ns(n, pdo) * node_id / (MAX_NODE_ID + 1);
+            }
+        }
+    }
+
+    //Command path: call it for every frame received from the application...
+    //...returns true if the frame is a command to a simulated controller.
+    bool handle_command(const can_message& message)
+    {
+        const uint32_t node_id = message.can_id - COMMAND_COB_ID;
+        if(message.can_id <= COMMAND_COB_ID || node_id > MAX_NODE_ID || !m_nodes[node_id].is_simulated || message.length == 0)
+        {
+            m_stats.unknown_count++;
+            return false;
+        }
+
+        node& n = m_nodes[node_id];
+        switch(message.payload[0])
+        {
+            case COMMAND_CODE_ESC:
+            {
+                m_stats.esc_count++;
+                if(n.fault_bits != 0 || message.length < 8) break;    //the motor stays de-energized until a RESET
+                memcpy(&(n.target_speed), &(message.payload[4]), sizeof(n.target_speed));
+                break;
+            }
+            case COMMAND_CODE_STOP:
+            {
+                m_stats.stop_count++;
+                n.target_speed = 0.0f;
+                break;
+            }
+            case COMMAND_CODE_RESET:
+            {
+                m_stats.reset_count++;
+                n.fault_bits   = 0;
+                n.target_speed = 0.0f;
+                n.speed        = 0.0f;
+                break;
+            }
+            default:
+            {
+                m_stats.unknown_count++;
+                return false;
+            }
+        }
+        return true;
+    }
+
+    //Timer path: plays the scenario events that are due, moves the motors and sends the telemetry that is due...
+    //...call it from a periodic timer, e.g. every millisecond; returns the number of telemetry frames sent.
+    template<typename Send>
+    size_t poll(uint64_t now_ns, Send send)
+    {
+        apply_events(now_ns);
+        move_motors(now_ns);
+
+        can_message messages[BATCH_SIZE];
+        size_t nmessages = 0;
+        size_t nsent = 0;
+        for(uint32_t node_id=1; node_id<=MAX_NODE_ID; node_id++)
+        {
+            node& n = m_nodes[node_id];
+            if(!n.is_simulated) continue;
+            const bool is_silent = (now_ns < n.silent_until_ns);
+
+            for(size_t pdo=0; pdo<PDO_COUNT; pdo++)
+            {
+                const uint64_t period_ns = get_period_ns(n, pdo);
+                if(period_ns == 0) continue;
+                if(now_ns > n.next_ns[pdo] + MAX_LAG_NS) n.next_ns[pdo] = now_ns;
+
+                while(n.next_ns[pdo] <= now_ns)
+                {
+                    n.next_ns[pdo] += period_ns;
+                    if(is_silent) continue;
+
+                    make_telemetry(node_id, n, pdo, messages[nmessages++]);
+                    if(nmessages == BATCH_SIZE)
+                    {
+                        nsent += send_batch(messages, nmessages, send);
+                        nmessages = 0;
+                    }
+                }
+            }
+        }
+        if(nmessages > 0) nsent += send_batch(messages, nmessages, send);
+        return nsent;
+    }
+
+    //the state of a simulated controller
+    uint16_t get_fault_bits(uint32_t node_id) const
+    {
+        return (node_id <= MAX_NODE_ID) ? m_nodes[node_id].fault_bits : 0;
+    }
+
+    float get_speed(uint32_t node_id) const
+    {
+        return (node_id <= MAX_NODE_ID) ? m_nodes[node_id].speed : 0.0f;
+    }
+
+    const simulation_stats& get_stats() const
+    {
+        return m_stats;
+    }
+
+    void reset_stats()
+    {
+        memset(&m_stats, 0, sizeof(m_stats));
+    }
+
+private:
+    static const size_t BATCH_SIZE = 64;
+
+    struct node
+    {
+        uint64_t next_ns[PDO_COUNT];    //when each telemetry message is due next
+        uint64_t silent_until_ns;
+        uint32_t period_ppm;
+        uint16_t sequence[PDO_COUNT];
+        uint16_t fault_bits;
+        float    speed;                 //Hz, electrical
+        float    target_speed;
+        bool     is_simulated;
+    };
+
+    node             m_nodes[MAX_NODE_ID + 1];
+    uint64_t         m_periods_ns[PDO_COUNT];
+    simulation_event m_events[MAX_EVENTS];      //sorted by time
+    size_t           m_event_count;
+    size_t           m_next_event;
+    uint64_t         m_start_ns;
+    uint64_t         m_previous_poll_ns;
+    float            m_acceleration;
+    float            m_voltage;
+    simulation_stats m_stats;
+
+    static size_t get_pdo_index(uint32_t cob_id)
+    {
+        return (cob_id >= 0x180 && cob_id <= 0x480 && (cob_id & 0x7F) == 0) ? (cob_id - 0x180) / 0x100 : PDO_COUNT;
+    }
+
+    uint64_t get_period_ns(const node& n, size_t pdo) const
+    {
+        return m_periods_ns[pdo] * n.period_ppm / NOMINAL_PPM;
+    }
+
+    void apply_events(uint64_t now_ns)
+    {
+        while(m_next_event < m_event_count && m_start_ns + m_events[m_next_event].at_ns <= now_ns)
+        {
+            const simulation_event& event = m_events[m_next_event++];
+            node& n = m_nodes[event.node_id];
+            if(!n.is_simulated) continue;
+            m_stats.event_count++;
+
+            switch(event.type)
+            {
+                case SIMULATION_FAULT:
+                {
+                    n.fault_bits  |= event.fault_bits;
+                    n.target_speed = 0.0f;
+                    n.speed        = 0.0f;      //de-energized; the telemetry reports no speed
+                    break;
+                }
+                case SIMULATION_SILENCE:
+                {
+                    n.silent_until_ns = now_ns + event.duration_ns;
+                    break;
+                }
+                case SIMULATION_DRIFT:
+                {
+                    n.period_ppm = (event.period_ppm > 0) ? event.period_ppm : NOMINAL_PPM;
+                    break;
+                }
+            }
+        }
+    }
+
+    void move_motors(uint64_t now_ns)
+    {
+        const float dt = static_cast<float>(now_ns - m_previous_poll_ns) * 1e-9f;
+        m_previous_poll_ns = now_ns;
+        const float step = m_acceleration * dt;
+
+        for(uint32_t node_id=1; node_id<=MAX_NODE_ID; node_id++)
+        {
+            node& n = m_nodes[node_id];
+            if(!n.is_simulated) continue;
+            if(n.speed < n.target_speed) n.speed = (n.speed + step < n.target_speed) ? n.speed + step : n.target_speed;
+            else if(n.speed > n.target_speed) n.speed = (n.speed - step > n.target_speed) ? n.speed - step : n.target_speed;
+        }
+    }
+
+    void make_telemetry(uint32_t node_id, node& n, size_t pdo, can_message& message) const
+    {
+        message.can_id = 0x180 + 0x100 * static_cast<uint32_t>(pdo) + node_id;
+        message.length = 8;
+        memset(message.payload, 0, sizeof(message.payload));
+        const uint16_t sequence = n.sequence[pdo]++;
+
+        if(pdo == 0)
+        {   //Fault Bits (UINT16, position 0), Udc (FLOAT16, position 2), speed (FLOAT32, position 4)
+            const int16_t voltage = encode_float16(m_voltage);
+            memcpy(&(message.payload[0]), &(n.fault_bits), sizeof(n.fault_bits));
+            memcpy(&(message.payload[2]), &voltage, sizeof(voltage));
+            memcpy(&(message.payload[4]), &(n.speed), sizeof(n.speed));
+            return;
+        }
+        const int16_t channels[4] =
+        {
+            static_cast<int16_t>(sequence),
+            static_cast<int16_t>(node_id),
+            saturate_int16(n.speed),    //a scenario or an ESC command may drive the speed beyond INT16
+            static_cast<int16_t>(n.fault_bits)
+        };
+        memcpy(message.payload, channels, sizeof(channels));
+    }
+
+    template<typename Send>
+    size_t send_batch(const can_message* messages, size_t count, Send& send)
+    {
+        const size_t nsent = send(messages, count);
+        m_stats.frames_sent    += nsent;
+        m_stats.frames_dropped += count - nsent;
+        return nsent;
+    }
+
+    //FLOAT32 to INT16, clamped to [INT16_MIN, INT16_MAX]: a plain cast of a value out of range is undefined behaviour; NaN becomes 0
+    static int16_t saturate_int16(float value)
+    {
+        if(value != value) return 0;
+        if(value <= static_cast<float>(INT16_MIN)) return INT16_MIN;
+        if(value >= static_cast<float>(INT16_MAX)) return INT16_MAX;
+        return static_cast<int16_t>(value);
+    }
+
+    //FLOAT32 to FLOAT16, rounded to the nearest; values too small for FLOAT16 become zero, values too large become infinity
+    static int16_t encode_float16(float value)
+    {
+        uint32_t bits;
+        memcpy(&bits, &value, sizeof(bits));
+        const uint32_t sign     = (bits >> 16) & 0x8000;
+        const int32_t  exponent = static_cast<int32_t>((bits >> 23) & 0xFF) - 127 + 15;
+        const uint32_t mantissa = bits & 0x007FFFFF;
+        if(exponent <= 0)  return static_cast<int16_t>(sign);
+        if(exponent >= 31) return static_cast<int16_t>(sign | 0x7C00);
+
+        uint32_t half = sign | (static_cast<uint32_t>(exponent) << 10) | (mantissa >> 13);
+        if(mantissa & 0x1000) half++;   //a carry into the exponent is still the nearest value
+        return static_cast<int16_t>(half);
+    }
+
+    controller_simulator(const controller_simulator&);              //non-copyable
+    controller_simulator& operator=(const controller_simulator&);
+};
+
+} //namespace servosila
+
+#endif // SERVOSILA_CONTROLLER_SIMULATOR_H
@@ -0,0 +1,175 @@
+/////////////////////////////////////////////////////////////////////////////
+//
+//  This source code comes with Servosila SC-25C Brushless Motor Controllers.
+//  An event-driven main loop (reactor) built on Linux epoll and timerfd.
+//      OS: Linux
+//
+//  The code is provided "AS IS" without any kind of guarantees or warranties.
+//  Use it at your own risk.
+//
+//  The code is free for everyone to use, modify or redistribute.
+//
+//  www.servosila.com
+//
+/////////////////////////////////////////////////////////////////////////////
+
+#ifndef SERVOSILA_EVENT_LOOP_H
+#define SERVOSILA_EVENT_LOOP_H
+
+#include <stdint.h>             //standard integer types
+#include <unistd.h>             //close(), read()
+#include <errno.h>              //errno, EINTR
+#include <sys/epoll.h>          //epoll_create1(), epoll_ctl(), epoll_wait()
+#include <sys/timerfd.h>        //timerfd_create(), timerfd_settime()
+#include <chrono>               //periods of timers, C++11
+#include <functional>           //std::function, C++11
+#include <list>                 //handlers keep their addresses in a list
+
+namespace servosila
+{
+
+//Instead of sleeping for a fixed period and then polling the devices, the main loop blocks in epoll_wait()
+//...and wakes up as soon as a CAN socket or a serial port has data, or as soon as a periodic timer expires.
+//Readers are expected to drain their descriptor completely each time they are called (the descriptors are non-blocking).
+//A descriptor that hangs up, e.g. the serial port of an unplugged USB-CAN adapter, would be reported by epoll again and again:
+//...its reader is called once more for the data still buffered, then its hang-up handler, and the descriptor leaves the loop.
+class event_loop
+{
+public:
+    event_loop() : m_epoll(::epoll_create1(EPOLL_CLOEXEC)), m_is_running(true) {}
+
+    ~event_loop()
+    {
+        for(std::list<handler>::iterator it = m_handlers.begin(); it != m_handlers.end(); ++it)
+        {
+            if(it->is_timer) ::close(it->fd);
+        }
+        if(m_epoll >= 0) ::close(m_epoll);
+    }
+
+    bool is_valid() const
+    {
+        return m_epoll >= 0;
+    }
+
+    //calls 'on_readable' whenever the descriptor (a CAN socket, a serial port) has data to be read out...
+    //...and 'on_hangup', if any, once the other side has gone, e.g. the USB-CAN adapter has been unplugged.
+    bool add_reader(int fd, const std::function<void()>& on_readable, const std::function<void()>& on_hangup = std::function<void()>())
+    {
+        return add_handler(fd, false, on_readable, on_hangup) != nullptr;
+    }
+
+    //calls 'on_timer' periodically, e.g. for sending out commands to controllers
+    //...the timer is driven by CLOCK_MONOTONIC, so it does not drift with the time spent in handlers.
+    bool add_timer(std::chrono::nanoseconds period, const std::function<void()>& on_timer)
+    {
+        const int fd = ::timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+        if(fd < 0) return false;
+
+        struct itimerspec spec;
+        spec.it_interval.tv_sec  = static_cast<time_t>(period.count() / 1000000000);
+        spec.it_interval.tv_nsec = static_cast<long>  (period.count() % 1000000000);
+        spec.it_value = spec.it_interval;
+        if(::timerfd_settime(fd, 0, &spec, nullptr) < 0 || add_handler(fd, true, on_timer, std::function<void()>()) == nullptr)
+        {
+            ::close(fd);
+            return false;
+        }
+        return true;
+    }
+
+    //runs the loop until stop() is called from one of the handlers
+    void run()
+    {
+        m_is_running = true;
+        while(m_is_running)
+        {
+            run_once(-1);
+        }
+    }
+
+    //waits for events for up to 'timeout_ms' milliseconds (-1 = forever) and dispatches them
+    //...returns the number of handlers called
+    int run_once(int timeout_ms)
+    {
+        struct epoll_event events[MAX_EVENTS];
+        const int nevents = ::epoll_wait(m_epoll, events, MAX_EVENTS, timeout_ms);
+        if(nevents < 0) return 0;   //EINTR: a signal arrived, the caller decides whether to continue
+
+        for(int i=0; i<nevents; i++)
+        {
+            handler* h = static_cast<handler*>(events[i].data.ptr);
+            if(h->is_timer)
+            {
+                //reading out the number of expirations to re-arm the timer descriptor
+                uint64_t expirations = 0;
+                if(::read(h->fd, &expirations, sizeof(expirations)) != sizeof(expirations)) continue;
+            }
+            h->callback();
+            //EPOLLERR alone is cleared by the read, e.g. ENETDOWN on a CAN socket; a hang-up is for good
+            if(events[i].events & EPOLLHUP)
+            {
+                ::epoll_ctl(m_epoll, EPOLL_CTL_DEL, h->fd, nullptr);
+                if(h->on_hangup) h->on_hangup();
+            }
+        }
+        return nevents;
+    }
+
+    //dispatches the events that are pending, without waiting, for loops that keep their own time (see realtime-loop.h)...
+    //...returns false once stop() has been called from one of the handlers.
+    bool run_pending()
+    {
+        while(run_once(0) == MAX_EVENTS) {}     //more events may be pending
+        return m_is_running;
+    }
+
+    void stop()
+    {
+        m_is_running = false;
+    }
+
+private:
+    static const int MAX_EVENTS = 16;
+
+    struct handler
+    {
+        int  fd;
+        bool is_timer;
+        std::function<void()> callback;
+        std::function<void()> on_hangup;
+    };
+
+    int  m_epoll;
+    bool m_is_running;
+    std::list<handler> m_handlers;  //a list keeps the handlers at fixed addresses that are registered with epoll
+
+    handler* add_handler(int fd, bool is_timer, const std::function<void()>& callback, const std::function<void()>& on_hangup)
+    {
+        if(m_epoll < 0 || fd < 0) return nullptr;
+
+        handler h;
+        h.fd        = fd;
+        h.is_timer  = is_timer;
+        h.callback  = callback;
+        h.on_hangup = on_hangup;
+        m_handlers.push_back(h);
+
+        struct epoll_event event;
+        event.events   = EPOLLIN;
+        event.data.ptr = &(m_handlers.back());
+        if(::epoll_ctl(m_epoll, EPOLL_CTL_ADD, fd, &event) < 0)
+        {
+            m_handlers.pop_back();
+            return nullptr;
+        }
+        return &(m_handlers.back());
+    }
+
+    event_loop(const event_loop&);              //non-copyable
+    event_loop& operator=(const event_loop&);
+};
+
+} //namespace servosila
+
+#endif // SERVOSILA_EVENT_LOOP_H
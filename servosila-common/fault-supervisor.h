@@ -0,0 +1,243 @@
+/////////////////////////////////////////////////////////////////////////////
+//
+//  This source code comes with Servosila SC-25C Brushless Motor Controllers.
+//  A supervisor that reacts to the Fault Bits of the controllers right in
+//  the receive path: STOP commands to dependent axes and automatic RESET
+//  with a growing back-off.
+//
+//  The code is provided "AS IS" without any kind of guarantees or warranties.
+//  Use it at your own risk.
+//
+//  The code is free for everyone to use, modify or redistribute.
+//
+//  www.servosila.com
+//
+/////////////////////////////////////////////////////////////////////////////
+
+#ifndef SERVOSILA_FAULT_SUPERVISOR_H
+#define SERVOSILA_FAULT_SUPERVISOR_H
+
+#include "can-message.h"
+#include "commands.h"           //make_stop_command(), make_reset_command()
+#include "command-scheduler.h"  //clear_command() of the stopped controllers
+#include "monotonic-clock.h"    //monotonic_ns()
+#include <stddef.h>             //size_t
+#include <stdint.h>             //standard integer types
+#include <string.h>             //memset()
+
+namespace servosila
+{
+
+//Reaction-time statistics: from the arrival of the telemetry message that reported a fault
+//...to the return from the call that handed the STOP commands over to the CAN transport.
+struct fault_reaction_stats
+{
+    uint64_t fault_count;       //rising edges of Fault Bits (0 -> non-zero)
+    uint64_t recovery_count;    //falling edges of Fault Bits (non-zero -> 0)
+    uint64_t reset_count;       //automatic RESET commands sent
+    uint64_t reaction_count;    //reactions measured
+    uint64_t reaction_min_ns;
+    uint64_t reaction_max_ns;
+    uint64_t reaction_sum_ns;   //reaction_sum_ns / reaction_count is the mean
+};
+
+//The supervisor is called by the receive loop for every decoded 0x180 telemetry message, on the same thread,
+//...so the STOP commands go out within microseconds of the fault report rather than on the next tick of a timer:
+//...- on a rising edge of Fault Bits of a controller, the controller and its dependent axes (e.g. the other motors
+//...  of the same machine) get a STOP command, so that none of them moves again once the fault is reset;
+//...- if automatic reset is enabled for the controller, RESET commands are sent by poll() with a back-off that doubles
+//...  after every attempt (e.g. 100ms, 200ms, 400ms...) until Fault Bits clear or the attempts run out;
+//...- the back-off starts over once the controller has run without a fault for a while.
+//'Send' is any callable 'void(const can_message* messages, size_t count)', e.g. a lambda around socketcan::send_many().
+//ATTENTION: the supervisor is not thread-safe; call it from the thread that receives the telemetry.
+class fault_supervisor
+{
+public:
+    static const uint32_t MAX_NODE_ID = 127;
+
+    fault_supervisor()
+        : m_p_scheduler(nullptr),
+          m_initial_backoff_ns(100000000ull),   //100ms
+          m_max_backoff_ns(5000000000ull),      //5s
+          m_stable_ns(10000000000ull),          //10s
+          m_max_reset_attempts(5)
+    {
+        memset(m_nodes, 0, sizeof(m_nodes));
+        reset_stats();
+    }
+
+    //starts supervising a controller; RESET commands are sent to it automatically if 'is_auto_reset' is true
+    bool add_node(uint32_t node_id, bool is_auto_reset = false)
+    {
+        if(node_id == 0 || node_id > MAX_NODE_ID) return false;
+        node& n = m_nodes[node_id];
+        n.is_supervised = true;
+        n.is_auto_reset = is_auto_reset;
+        return true;
+    }
+
+    //'dependent_node_id' gets a STOP command whenever 'node_id' reports a fault
+    bool add_dependency(uint32_t node_id, uint32_t dependent_node_id)
+    {
+        if(node_id > MAX_NODE_ID || dependent_node_id == 0 || dependent_node_id > MAX_NODE_ID) return false;
+        m_nodes[node_id].dependents[dependent_node_id >> 6] |= uint64_t(1) << (dependent_node_id & 63);
+        return true;
+    }
+
+    //the automatic reset policy
+    //...'stable_ns' is how long a controller must run without a fault before the back-off starts over.
+    void set_reset_policy(uint64_t initial_backoff_ns, uint64_t max_backoff_ns, uint32_t max_attempts, uint64_t stable_ns)
+    {
+        m_initial_backoff_ns = initial_backoff_ns;
+        m_max_backoff_ns     = max_backoff_ns;
+        m_max_reset_attempts = max_attempts;
+        m_stable_ns          = stable_ns;
+    }
+
+    //the stopped controllers are dropped from the scheduler, so that their ESC commands are not repeated
+    void set_scheduler(command_scheduler* p_scheduler)
+    {
+        m_p_scheduler = p_scheduler;
+    }
+
+    //Receive path: 'timestamp_ns' is the monotonic_ns() time of arrival of the telemetry message...
+    //...returns true on a rising edge of Fault Bits.
+    template<typename Send>
+    bool update(uint32_t node_id, uint16_t fault_bits, uint64_t timestamp_ns, Send send)
+    {
+        if(node_id > MAX_NODE_ID || !m_nodes[node_id].is_supervised) return false;
+        node& n = m_nodes[node_id];
+        const bool was_faulted = n.is_faulted;
+        n.is_faulted = (fault_bits != 0);
+        n.fault_bits = fault_bits;
+
+        if(!n.is_faulted)
+        {
+            if(was_faulted)
+            {
+                m_stats.recovery_count++;
+                n.recovered_ns = timestamp_ns;
+            }
+            n.next_reset_ns = 0;
+            return false;
+        }
+        if(was_faulted) return false;   //the fault is known already
+
+        //a rising edge: stopping the controller and its dependent axes right away
+        m_stats.fault_count++;
+        can_message messages[MAX_NODE_ID];
+        size_t nmessages = 0;
+        messages[nmessages++] = make_stop_command(node_id);
+        if(m_p_scheduler != nullptr) m_p_scheduler->clear_command(node_id);
+        for(uint32_t dependent=1; dependent<=MAX_NODE_ID; dependent++)
+        {
+            if(dependent == node_id || !(n.dependents[dependent >> 6] & (uint64_t(1) << (dependent & 63)))) continue;
+            messages[nmessages++] = make_stop_command(dependent);
+            if(m_p_scheduler != nullptr) m_p_scheduler->clear_command(dependent);
+        }
+        send(messages, nmessages);
+        record_reaction(monotonic_ns() - timestamp_ns);
+
+        //scheduling the first automatic reset; a controller that has been stable for a while starts with the shortest back-off
+        if(n.is_auto_reset)
+        {
+            if(n.recovered_ns == 0 || timestamp_ns - n.recovered_ns >= m_stable_ns)
+            {
+                n.reset_attempts = 0;
+                n.backoff_ns     = m_initial_backoff_ns;
+            }
+            n.next_reset_ns = (n.reset_attempts < m_max_reset_attempts) ? timestamp_ns + n.backoff_ns : 0;
+        }
+        return true;
+    }
+
+    //Timer path: sends the automatic RESET commands that are due; returns the number of commands sent.
+    //...call it from a periodic timer of the receive thread, e.g. every 10ms.
+    template<typename Send>
+    size_t poll(uint64_t now_ns, Send send)
+    {
+        can_message messages[MAX_NODE_ID];
+        size_t nmessages = 0;
+        for(uint32_t node_id=1; node_id<=MAX_NODE_ID; node_id++)
+        {
+            node& n = m_nodes[node_id];
+            if(!n.is_faulted || n.next_reset_ns == 0 || now_ns < n.next_reset_ns) continue;
+
+            messages[nmessages++] = make_reset_command(node_id);
+            n.reset_attempts++;
+            n.backoff_ns = (2 * n.backoff_ns < m_max_backoff_ns) ? 2 * n.backoff_ns : m_max_backoff_ns;
+            //if Fault Bits do not clear, the reset is tried again after the back-off, until the attempts run out
+            n.next_reset_ns = (n.reset_attempts < m_max_reset_attempts) ? now_ns + n.backoff_ns : 0;
+        }
+        if(nmessages > 0) send(messages, nmessages);
+        m_stats.reset_count += nmessages;
+        return nmessages;
+    }
+
+    bool is_faulted(uint32_t node_id) const
+    {
+        return node_id <= MAX_NODE_ID && m_nodes[node_id].is_faulted;
+    }
+
+    //the latest Fault Bits of a controller
+    uint16_t get_fault_bits(uint32_t node_id) const
+    {
+        return (node_id <= MAX_NODE_ID) ? m_nodes[node_id].fault_bits : 0;
+    }
+
+    //true if the automatic reset of a faulted controller has given up; a RESET has to come from the operator
+    bool is_reset_exhausted(uint32_t node_id) const
+    {
+        if(node_id > MAX_NODE_ID) return false;
+        const node& n = m_nodes[node_id];
+        return n.is_faulted && n.is_auto_reset && n.next_reset_ns == 0;
+    }
+
+    const fault_reaction_stats& get_stats() const
+    {
+        return m_stats;
+    }
+
+    void reset_stats()
+    {
+        memset(&m_stats, 0, sizeof(m_stats));
+        m_stats.reaction_min_ns = ~0ull;
+    }
+
+private:
+    struct node
+    {
+        uint64_t dependents[2];     //a bit per Node ID
+        uint64_t next_reset_ns;     //0 if no automatic reset is pending
+        uint64_t backoff_ns;
+        uint64_t recovered_ns;      //the time Fault Bits cleared last; 0 if they have never been set
+        uint32_t reset_attempts;
+        uint16_t fault_bits;
+        bool     is_supervised;
+        bool     is_auto_reset;
+        bool     is_faulted;
+    };
+
+    node                 m_nodes[MAX_NODE_ID + 1];
+    command_scheduler*   m_p_scheduler;
+    uint64_t             m_initial_backoff_ns;
+    uint64_t             m_max_backoff_ns;
+    uint64_t             m_stable_ns;
+    uint32_t             m_max_reset_attempts;
+    fault_reaction_stats m_stats;
+
+    void record_reaction(uint64_t reaction_ns)
+    {
+        m_stats.reaction_count++;
+        m_stats.reaction_sum_ns += reaction_ns;
+        if(reaction_ns < m_stats.reaction_min_ns) m_stats.reaction_min_ns = reaction_ns;
+        if(reaction_ns > m_stats.reaction_max_ns) m_stats.reaction_max_ns = reaction_ns;
+    }
+
+    fault_supervisor(const fault_supervisor&);              //non-copyable
+    fault_supervisor& operator=(const fault_supervisor&);
+};
+
+} //namespace servosila
+
+#endif // SERVOSILA_FAULT_SUPERVISOR_H
@@ -0,0 +1,149 @@
+/////////////////////////////////////////////////////////////////////////////
+//
+//  This source code comes with Servosila SC-25C Brushless Motor Controllers.
+//  Conversion of arrays of FLOAT16 values, e.g. when post-processing
+//  recorded telemetry.
+//
+//  The code is provided "AS IS" without any kind of guarantees or warranties.
+//  Use it at your own risk.
+//
+//  The code is free for everyone to use, modify or redistribute.
+//
+//  www.servosila.com
+//
+/////////////////////////////////////////////////////////////////////////////
+
+#ifndef SERVOSILA_FLOAT16_BATCH_H
+#define SERVOSILA_FLOAT16_BATCH_H
+
+#include <stddef.h>     //size_t
+#include <stdint.h>     //standard integer types
+#include <string.h>     //memcpy()
+
+//x86-64: F16C converts 8 values per instruction; it is not present on every CPU, so it is detected at run time.
+//AArch64: the conversion is part of the base instruction set.
+//Other targets, or SERVOSILA_NO_SIMD: a table-based conversion without branches.
+#if !defined(SERVOSILA_NO_SIMD) && defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+    #define SERVOSILA_FLOAT16_F16C
+    #include <immintrin.h>      //F16C and AVX intrinsics
+#elif !defined(SERVOSILA_NO_SIMD) && defined(__aarch64__)
+    #define SERVOSILA_FLOAT16_NEON
+    #include <arm_neon.h>       //NEON intrinsics
+#endif
+
+namespace servosila
+{
+
+namespace float16_detail
+{
+    //Lookup tables of the FLOAT16->FLOAT32 conversion: the FLOAT32 bits of a FLOAT16 value are
+    //...mantissa[offset[h >> 10] + (h & 0x3FF)] + exponent[h >> 10]; subnormal values are normalized by the mantissa table.
+    struct tables
+    {
+        uint32_t mantissa[2048];
+        uint32_t exponent[64];
+        uint16_t offset[64];
+
+        tables()
+        {
+            mantissa[0] = 0;
+            for(uint32_t i=1; i<1024; i++)
+            {   //subnormal FLOAT16 values become normal FLOAT32 values
+                uint32_t m = i << 13;
+                uint32_t e = 0;
+                while(!(m & 0x00800000))
+                {
+                    e -= 0x00800000;
+                    m <<= 1;
+                }
+                m &= ~0x00800000u;
+                e += 0x38800000;
+                mantissa[i] = m | e;
+            }
+            for(uint32_t i=1024; i<2048; i++) mantissa[i] = 0x38000000 + ((i - 1024) << 13);
+
+            exponent[0]  = 0;
+            for(uint32_t i=1; i<31; i++) exponent[i] = i << 23;
+            exponent[31] = 0x47800000;  //infinities and NaNs
+            exponent[32] = 0x80000000;
+            for(uint32_t i=33; i<63; i++) exponent[i] = 0x80000000 + ((i - 32) << 23);
+            exponent[63] = 0xC7800000;
+
+            for(uint32_t i=0; i<64; i++) offset[i] = 1024;
+            offset[0]  = 0;
+            offset[32] = 0;
+        }
+    };
+
+    //the tables are built once, on the first use (about 8.5 KB)
+    inline const tables& get_tables()
+    {
+        static const tables instance;
+        return instance;
+    }
+
+    inline float convert(const tables& t, int16_t value)
+    {
+        const uint16_t h = static_cast<uint16_t>(value);
+        const uint32_t bits = t.mantissa[t.offset[h >> 10] + (h & 0x3FF)] + t.exponent[h >> 10];
+        float result;
+        memcpy(&result, &bits, sizeof(result));
+        return result;
+    }
+
+#if defined(SERVOSILA_FLOAT16_F16C)
+    __attribute__((target("avx,f16c")))
+    inline void decode_f16c(const int16_t* values, float* results, size_t count, const tables& t)
+    {
+        size_t i = 0;
+        for(; i + 8 <= count; i += 8)
+        {
+            const __m128i halves = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&(values[i])));
+            _mm256_storeu_ps(&(results[i]), _mm256_cvtph_ps(halves));
+        }
+        for(; i < count; i++) results[i] = convert(t, values[i]);
+    }
+
+    inline bool has_f16c()
+    {
+        static const bool result = __builtin_cpu_supports("avx") && __builtin_cpu_supports("f16c");
+        return result;
+    }
+#endif
+} //namespace float16_detail
+
+//Converts a FLOAT16 value (transmitted as INT16) to FLOAT32 with a table lookup.
+//...the result is the same as that of decode_float16().
+inline float decode_float16_table(int16_t value)
+{
+    return float16_detail::convert(float16_detail::get_tables(), value);
+}
+
+//Converts 'count' FLOAT16 values (transmitted as INT16) to FLOAT32 using the fastest method the CPU supports.
+inline void decode_float16_batch(const int16_t* values, float* results, size_t count)
+{
+    const float16_detail::tables& t = float16_detail::get_tables();
+
+#if defined(SERVOSILA_FLOAT16_F16C)
+    if(float16_detail::has_f16c())
+    {
+        float16_detail::decode_f16c(values, results, count, t);
+        return;
+    }
+#elif defined(SERVOSILA_FLOAT16_NEON)
+    size_t i = 0;
+    for(; i + 4 <= count; i += 4)
+    {
+        vst1q_f32(&(results[i]), vcvt_f32_f16(vreinterpret_f16_s16(vld1_s16(&(values[i])))));
+    }
+    values  += i;
+    results += i;
+    count   -= i;
+#endif
+
+    for(size_t j=0; j<count; j++) results[j] = float16_detail::convert(t, values[j]);
+}
+
+} //namespace servosila
+
+#endif // SERVOSILA_FLOAT16_BATCH_H
@@ -0,0 +1,91 @@
+/////////////////////////////////////////////////////////////////////////////
+//
+//  This source code comes with Servosila SC-25C Brushless Motor Controllers.
+//  A reader of binary CAN frame logs recorded by frame_logger.
+//
+//  The code is provided "AS IS" without any kind of guarantees or warranties.
+//  Use it at your own risk.
+//
+//  The code is free for everyone to use, modify or redistribute.
+//
+//  www.servosila.com
+//
+/////////////////////////////////////////////////////////////////////////////
+
+#ifndef SERVOSILA_FRAME_LOG_READER_H
+#define SERVOSILA_FRAME_LOG_READER_H
+
+#include "can-message.h"
+#include "frame-logger.h"   //frame_log_header, frame_log_record, frame_log_session
+#include <stddef.h>         //size_t
+#include <string.h>         //memcmp(), memcpy()
+
+namespace servosila
+{
+
+//Reads the records of a frame log in place, e.g. from a mapped_file; nothing is copied.
+//...a record cut short at the end of the log (the recording was interrupted) is ignored.
+class frame_log_reader
+{
+public:
+    frame_log_reader() : m_records(nullptr), m_count(0) {}
+
+    //checks the header of a log that is held in memory; returns false if the data is not a frame log
+    bool attach(const void* data, size_t size)
+    {
+        m_records = nullptr;
+        m_count = 0;
+        if(!is_frame_log(data, size)) return false;
+
+        frame_log_header header;
+        memcpy(&header, data, sizeof(header));
+        if(header.version != FRAME_LOG_VERSION || header.record_size != sizeof(frame_log_record)) return false;
+
+        m_records = reinterpret_cast<const frame_log_record*>(static_cast<const char*>(data) + sizeof(frame_log_header));
+        m_count = (size - sizeof(frame_log_header)) / sizeof(frame_log_record);
+        return true;
+    }
+
+    //tells a binary frame log from other data, e.g. from SLCAN text, by its magic
+    static bool is_frame_log(const void* data, size_t size)
+    {
+        return size >= sizeof(frame_log_header) && memcmp(data, FRAME_LOG_MAGIC, sizeof(FRAME_LOG_MAGIC)) == 0;
+    }
+
+    size_t get_count() const
+    {
+        return m_count;
+    }
+
+    const frame_log_record& get_record(size_t index) const
+    {
+        return m_records[index];
+    }
+
+    //tells the session record written by every frame_logger::open() from the frames
+    static bool is_session(const frame_log_record& record)
+    {
+        return record.can_id == FRAME_LOG_SESSION_ID;
+    }
+
+    static void to_session(const frame_log_record& record, frame_log_session& session)
+    {
+        memcpy(&session, &record, sizeof(session));
+    }
+
+    //converts a record into a can_message as it would be delivered by a transport
+    static void to_can_message(const frame_log_record& record, can_message& message)
+    {
+        message.can_id = record.can_id;
+        message.length = (record.length <= 8) ? record.length : 8;
+        memcpy(message.payload, record.payload, sizeof(message.payload));
+    }
+
+private:
+    const frame_log_record* m_records;  //the header is 16 bytes long, so the records stay 8-byte aligned in a mapped file
+    size_t                  m_count;
+};
+
+} //namespace servosila
+
+#endif // SERVOSILA_FRAME_LOG_READER_H
@@ -0,0 +1,305 @@
+/////////////////////////////////////////////////////////////////////////////
+//
+//  This source code comes with Servosila SC-25C Brushless Motor Controllers.
+//  A binary recorder of CAN traffic that keeps up with a fully loaded bus.
+//      OS: Linux
+//
+//  The code is provided "AS IS" without any kind of guarantees or warranties.
+//  Use it at your own risk.
+//
+//  The code is free for everyone to use, modify or redistribute.
+//
+//  www.servosila.com
+//
+/////////////////////////////////////////////////////////////////////////////
+
+#ifndef SERVOSILA_FRAME_LOGGER_H
+#define SERVOSILA_FRAME_LOGGER_H
+
+#include "can-message.h"
+#include "monotonic-clock.h"    //monotonic_ns()
+#include <stddef.h>             //size_t, offsetof
+#include <stdint.h>             //standard integer types
+#include <stdlib.h>             //strtoul()
+#include <string.h>             //memcpy(), memset()
+#include <time.h>               //clock_gettime()
+#include <fcntl.h>              //open()
+#include <unistd.h>             //read(), write(), close()
+#include <errno.h>              //errno, EINTR
+#include <signal.h>             //pthread_sigmask()
+#include <sys/stat.h>           //fstat()
+#include <atomic>               //lock-free ring buffer indices, C++11
+#include <chrono>               //writer thread's polling period, C++11
+#include <thread>               //writer thread, C++11
+#include <vector>               //preallocated ring buffer
+
+namespace servosila
+{
+
+//A frame log file is a header followed by fixed-size records, one record per CAN frame, in the order of arrival.
+//...all integers are stored in the byte order of the host that recorded the log (little-endian on x86 and ARM).
+struct frame_log_header
+{
+    char     magic[8];      //FRAME_LOG_MAGIC
+    uint32_t version;       //FRAME_LOG_VERSION
+    uint32_t record_size;   //sizeof(frame_log_record)
+};
+
+struct frame_log_record
+{
+    uint64_t timestamp_ns;      //monotonic_ns() time of arrival
+    uint32_t can_id;            //11-bit or 29-bit CAN ID
+    uint8_t  length;            //number of payload bytes, 0..8
+    uint8_t  timestamp_source;  //rx_timestamp_source of 'timestamp_ns'; 0 (TIMESTAMP_RECEIVE) in the logs of older versions
+    uint8_t  reserved[2];
+    uint8_t  payload[8];        //the bytes beyond 'length' are zeroed
+};
+
+//Every open() appends a session record before the frames of the session, so that the recordings appended
+//...to one file can be told apart: the monotonic time of the records does not run while nothing is recorded
+//...and restarts from zero with every boot. A session record has the size of a frame record and carries
+//...FRAME_LOG_SESSION_ID where a frame record has its CAN ID; the logs of older versions have none.
+struct frame_log_session
+{
+    uint64_t start_ns;          //monotonic_ns() time of open(), on the same time line as the frames that follow
+    uint32_t session_id;        //FRAME_LOG_SESSION_ID
+    uint32_t boot_id;           //the first 32 bits of /proc/sys/kernel/random/boot_id; 0 if unknown
+    uint64_t start_realtime_ns; //CLOCK_REALTIME time of open(), i.e. the wall-clock time of 'start_ns'
+};
+
+static const char     FRAME_LOG_MAGIC[8]    = { 'S', 'V', 'C', 'A', 'N', 'L', 'O', 'G' };
+static const uint32_t FRAME_LOG_VERSION     = 1;
+static const uint32_t FRAME_LOG_SESSION_ID  = 0xFFFFFFFF;   //beyond any 29-bit CAN ID
+
+static_assert(sizeof(frame_log_header) == 16, "unexpected padding in frame_log_header");
+static_assert(sizeof(frame_log_record) == 24, "unexpected padding in frame_log_record");
+static_assert(sizeof(frame_log_session) == sizeof(frame_log_record), "a session record must have the size of a frame record");
+static_assert(offsetof(frame_log_session, session_id) == offsetof(frame_log_record, can_id), "unexpected layout of frame_log_session");
+
+//The receive loop calls log() for every frame; log() only copies the frame into a preallocated ring buffer
+//...and never blocks or enters the kernel. A background thread moves the records to the file in large blocks.
+//...If the disk cannot keep up and the ring buffer fills up, new frames are dropped and counted.
+//ATTENTION: log() must be called from one thread only.
+class frame_logger
+{
+public:
+    //capacity is the number of frames the ring buffer holds, rounded up to a power of two;
+    //...65536 frames cover more than 8 seconds of a fully loaded 1 Mbit/s bus.
+    explicit frame_logger(size_t capacity = 65536)
+        : m_mask(0), m_file(-1), m_is_running(false),
+          m_head(0), m_dropped_count(0), m_tail(0), m_write_error_count(0)
+    {
+        size_t size = 1;
+        while(size < capacity) size <<= 1;
+        m_ring.resize(size);
+        m_mask = size - 1;
+    }
+
+    ~frame_logger()
+    {
+        close();
+    }
+
+    //opens a log file for appending and starts the writer thread...
+    //...a header is written if the file is new or empty, then a session record.
+    bool open(const char* file_name)
+    {
+        close();
+
+        m_file = ::open(file_name, O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+        if(m_file < 0) return false;
+
+        struct stat file_stat;
+        if(::fstat(m_file, &file_stat) == 0 && file_stat.st_size == 0)
+        {
+            frame_log_header header;
+            memcpy(header.magic, FRAME_LOG_MAGIC, sizeof(header.magic));
+            header.version     = FRAME_LOG_VERSION;
+            header.record_size = sizeof(frame_log_record);
+            if(!write_all(&header, sizeof(header)))
+            {
+                ::close(m_file);
+                m_file = -1;
+                return false;
+            }
+        }
+
+        frame_log_session session;
+        session.start_ns          = monotonic_ns();
+        session.session_id        = FRAME_LOG_SESSION_ID;
+        session.boot_id           = read_boot_id();
+        session.start_realtime_ns = realtime_ns();
+        if(!write_all(&session, sizeof(session)))
+        {
+            ::close(m_file);
+            m_file = -1;
+            return false;
+        }
+
+        m_is_running.store(true, std::memory_order_release);
+        m_writer = std::thread(&frame_logger::writer_loop, this);
+        return true;
+    }
+
+    //writes out the frames still in the ring buffer, stops the writer thread and closes the file
+    void close()
+    {
+        if(m_writer.joinable())
+        {
+            m_is_running.store(false, std::memory_order_release);
+            m_writer.join();
+        }
+        if(m_file >= 0)
+        {
+            ::close(m_file);
+            m_file = -1;
+        }
+    }
+
+    bool is_open() const
+    {
+        return m_file >= 0;
+    }
+
+    //queues a frame for writing; returns false if the ring buffer is full and the frame has been dropped
+    bool log(const can_message& message, uint64_t timestamp_ns, rx_timestamp_source timestamp_source = TIMESTAMP_RECEIVE)
+    {
+        const uint64_t head = m_head.load(std::memory_order_relaxed);
+        if(head - m_tail.load(std::memory_order_acquire) > m_mask)
+        {
+            m_dropped_count.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+
+        frame_log_record& record = m_ring[head & m_mask];
+        record.timestamp_ns = timestamp_ns;
+        record.can_id       = message.can_id;
+        record.length       = message.length;
+        record.timestamp_source = static_cast<uint8_t>(timestamp_source);
+        memset(record.reserved, 0, sizeof(record.reserved));
+        memcpy(record.payload, message.payload, sizeof(record.payload));
+
+        m_head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    //same as above, the frame is timestamped with monotonic_ns()
+    bool log(const can_message& message)
+    {
+        return log(message, monotonic_ns());
+    }
+
+    //number of frames dropped because the ring buffer was full
+    uint64_t get_dropped_count() const
+    {
+        return m_dropped_count.load(std::memory_order_relaxed);
+    }
+
+    //number of frames written to the file so far
+    uint64_t get_written_count() const
+    {
+        return m_tail.load(std::memory_order_relaxed);
+    }
+
+    //number of failed writes to the file; the frames of a failed write are lost
+    uint64_t get_write_error_count() const
+    {
+        return m_write_error_count.load(std::memory_order_relaxed);
+    }
+
+private:
+    std::vector<frame_log_record> m_ring;
+    uint64_t            m_mask;
+    int                 m_file;
+    std::thread         m_writer;
+    std::atomic<bool>   m_is_running;
+
+    //the indices are on separate cache lines, so that the receive loop and the writer thread do not slow each other down
+    alignas(64) std::atomic<uint64_t> m_head;               //written by log()
+    std::atomic<uint64_t>             m_dropped_count;
+    alignas(64) std::atomic<uint64_t> m_tail;               //written by the writer thread
+    std::atomic<uint64_t>             m_write_error_count;
+
+    void writer_loop()
+    {
+        //signals are for the application's thread; a signal delivered here would take the default action, e.g. end the process
+        sigset_t signals;
+        sigfillset(&signals);
+        ::pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+
+        while(true)
+        {
+            const bool is_running = m_is_running.load(std::memory_order_acquire);
+            const size_t nwritten = write_pending();
+            if(!is_running) break;  //everything queued before close() has been written out
+            //nothing to do: sleeping for a while, so that the frames are written in larger and fewer blocks
+            if(nwritten == 0) std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+    }
+
+    //writes out all queued records, in at most two blocks when the queued records wrap around the end of the ring buffer
+    size_t write_pending()
+    {
+        const uint64_t head = m_head.load(std::memory_order_acquire);
+        uint64_t tail = m_tail.load(std::memory_order_relaxed);
+        const uint64_t queued = head - tail;
+
+        while(tail != head)
+        {
+            const size_t index = static_cast<size_t>(tail & m_mask);
+            const size_t contiguous = m_ring.size() - index;
+            const size_t count = (head - tail < contiguous) ? static_cast<size_t>(head - tail) : contiguous;
+
+            if(!write_all(&(m_ring[index]), count * sizeof(frame_log_record)))
+            {
+                m_write_error_count.fetch_add(1, std::memory_order_relaxed);
+            }
+            tail += count;
+            m_tail.store(tail, std::memory_order_release);   //the slots may be reused by log() now
+        }
+        return static_cast<size_t>(queued);
+    }
+
+    bool write_all(const void* data, size_t size)
+    {
+        const char* position = static_cast<const char*>(data);
+        while(size > 0)
+        {
+            const ssize_t nwritten = ::write(m_file, position, size);
+            if(nwritten < 0)
+            {
+                if(errno == EINTR) continue;
+                return false;
+            }
+            position += nwritten;
+            size -= static_cast<size_t>(nwritten);
+        }
+        return true;
+    }
+
+    //the first 8 hex digits of the random UUID the kernel generates at boot
+    static uint32_t read_boot_id()
+    {
+        char text[9] = { 0 };
+        const int file = ::open("/proc/sys/kernel/random/boot_id", O_RDONLY | O_CLOEXEC);
+        if(file < 0) return 0;
+        const ssize_t nread = ::read(file, text, 8);
+        ::close(file);
+        if(nread != 8) return 0;
+        return static_cast<uint32_t>(strtoul(text, nullptr, 16));
+    }
+
+    static uint64_t realtime_ns()
+    {
+        struct timespec ts;
+        ::clock_gettime(CLOCK_REALTIME, &ts);
+        return static_cast<uint64_t>(ts.tv_sec) * 1000000000ull + static_cast<uint64_t>(ts.tv_nsec);
+    }
+
+    frame_logger(const frame_logger&);              //non-copyable
+    frame_logger& operator=(const frame_logger&);
+};
+
+} //namespace servosila
+
+#endif // SERVOSILA_FRAME_LOGGER_H
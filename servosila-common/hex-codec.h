@@ -0,0 +1,162 @@
+/////////////////////////////////////////////////////////////////////////////
+//
+//  This source code comes with Servosila SC-25C Brushless Motor Controllers.
+//  Conversion of CAN payloads to and from the hexadecimal text of SLCAN frames.
+//
+//  The code is provided "AS IS" without any kind of guarantees or warranties.
+//  Use it at your own risk.
+//
+//  The code is free for everyone to use, modify or redistribute.
+//
+//  www.servosila.com
+//
+/////////////////////////////////////////////////////////////////////////////
+
+#ifndef SERVOSILA_HEX_CODEC_H
+#define SERVOSILA_HEX_CODEC_H
+
+#include <stddef.h>     //size_t
+#include <stdint.h>     //standard integer types
+#include <string.h>     //memcpy(), memset()
+
+//A whole 8-byte CAN payload is 16 hexadecimal symbols, which is exactly one 128-bit vector register.
+//...SSE2 is part of every x86-64 CPU and NEON is part of every 64-bit ARM CPU, so the vector code is chosen
+//...at compile time and no run-time CPU detection is needed; other targets get the scalar code.
+//...Define SERVOSILA_NO_SIMD to force the scalar code, e.g. to compare the results.
+#if !defined(SERVOSILA_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64))
+    #define SERVOSILA_HEX_CODEC_SSE2
+    #include <emmintrin.h>      //SSE2 intrinsics
+#elif !defined(SERVOSILA_NO_SIMD) && defined(__aarch64__)
+    #define SERVOSILA_HEX_CODEC_NEON
+    #include <arm_neon.h>       //NEON intrinsics
+#endif
+
+namespace servosila
+{
+
+namespace hex_detail
+{
+    static const char HEX_SYMBOLS[] = "0123456789ABCDEF";
+
+    inline int decode_hex_symbol(char symbol)
+    {
+        if(symbol >= '0' && symbol <= '9') return symbol - '0';
+        if(symbol >= 'A' && symbol <= 'F') return symbol - 'A' + 10;
+        if(symbol >= 'a' && symbol <= 'f') return symbol - 'a' + 10;
+        return -1;
+    }
+} //namespace hex_detail
+
+//Scalar reference implementations; the vector code produces exactly the same results.
+//...'symbols' receives 2*count upper-case hexadecimal symbols, the high nibble first.
+inline void encode_hex_scalar(const uint8_t* bytes, size_t count, char* symbols)
+{
+    for(size_t i=0; i<count; i++)
+    {
+        symbols[2*i]     = hex_detail::HEX_SYMBOLS[bytes[i] >> 4];
+        symbols[2*i + 1] = hex_detail::HEX_SYMBOLS[bytes[i] & 0x0F];
+    }
+}
+
+//...accepts upper-case and lower-case symbols; returns false if any of 2*count symbols is not hexadecimal.
+inline bool decode_hex_scalar(const char* symbols, size_t count, uint8_t* bytes)
+{
+    for(size_t i=0; i<count; i++)
+    {
+        const int high = hex_detail::decode_hex_symbol(symbols[2*i]);
+        const int low  = hex_detail::decode_hex_symbol(symbols[2*i + 1]);
+        if(high < 0 || low < 0) return false;
+        bytes[i] = static_cast<uint8_t>((high << 4) | low);
+    }
+    return true;
+}
+
+//Encodes exactly 8 bytes into 16 symbols.
+inline void encode_hex8(const uint8_t* bytes, char* symbols)
+{
+#if defined(SERVOSILA_HEX_CODEC_SSE2)
+    const __m128i value   = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(bytes));
+    const __m128i mask    = _mm_set1_epi8(0x0F);
+    const __m128i high    = _mm_and_si128(_mm_srli_epi16(value, 4), mask);
+    const __m128i low     = _mm_and_si128(value, mask);
+    const __m128i nibbles = _mm_unpacklo_epi8(high, low);   //high and low nibbles interleaved, the high nibble first
+    //'0'..'9' for 0..9, and 7 more for 'A'..'F'
+    const __m128i letters = _mm_and_si128(_mm_cmpgt_epi8(nibbles, _mm_set1_epi8(9)), _mm_set1_epi8(7));
+    const __m128i ascii   = _mm_add_epi8(_mm_add_epi8(nibbles, _mm_set1_epi8('0')), letters);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(symbols), ascii);
+#elif defined(SERVOSILA_HEX_CODEC_NEON)
+    const uint8x8_t   value   = vld1_u8(bytes);
+    const uint8x8x2_t zipped  = vzip_u8(vshr_n_u8(value, 4), vand_u8(value, vdup_n_u8(0x0F)));
+    const uint8x16_t  nibbles = vcombine_u8(zipped.val[0], zipped.val[1]);
+    const uint8x16_t  letters = vandq_u8(vcgtq_u8(nibbles, vdupq_n_u8(9)), vdupq_n_u8(7));
+    const uint8x16_t  ascii   = vaddq_u8(vaddq_u8(nibbles, vdupq_n_u8('0')), letters);
+    vst1q_u8(reinterpret_cast<uint8_t*>(symbols), ascii);
+#else
+    encode_hex_scalar(bytes, 8, symbols);
+#endif
+}
+
+//Decodes exactly 16 symbols into 8 bytes; returns false if any of the symbols is not hexadecimal.
+inline bool decode_hex8(const char* symbols, uint8_t* bytes)
+{
+#if defined(SERVOSILA_HEX_CODEC_SSE2)
+    const __m128i text     = _mm_loadu_si128(reinterpret_cast<const __m128i*>(symbols));
+    //digits: 0..9 after subtracting '0'; letters of either case: 0..5 after folding to lower case and subtracting 'a'
+    const __m128i digit    = _mm_sub_epi8(text, _mm_set1_epi8('0'));
+    const __m128i letter   = _mm_sub_epi8(_mm_or_si128(text, _mm_set1_epi8(0x20)), _mm_set1_epi8('a'));
+    const __m128i is_digit = _mm_cmpeq_epi8(_mm_min_epu8(digit,  _mm_set1_epi8(9)), digit);
+    const __m128i is_letter= _mm_cmpeq_epi8(_mm_min_epu8(letter, _mm_set1_epi8(5)), letter);
+    if(_mm_movemask_epi8(_mm_or_si128(is_digit, is_letter)) != 0xFFFF) return false;
+
+    const __m128i nibbles  = _mm_or_si128(_mm_and_si128(is_digit, digit), _mm_andnot_si128(is_digit, _mm_add_epi8(letter, _mm_set1_epi8(10))));
+    //every 16-bit lane holds a high nibble (lower byte) and a low nibble (upper byte); joining them into the lower byte
+    const __m128i joined   = _mm_or_si128(_mm_slli_epi16(nibbles, 4), _mm_srli_epi16(nibbles, 8));
+    const __m128i packed   = _mm_packus_epi16(_mm_and_si128(joined, _mm_set1_epi16(0x00FF)), _mm_setzero_si128());
+    _mm_storel_epi64(reinterpret_cast<__m128i*>(bytes), packed);
+    return true;
+#elif defined(SERVOSILA_HEX_CODEC_NEON)
+    const uint8x16_t text      = vld1q_u8(reinterpret_cast<const uint8_t*>(symbols));
+    const uint8x16_t digit     = vsubq_u8(text, vdupq_n_u8('0'));
+    const uint8x16_t letter    = vsubq_u8(vorrq_u8(text, vdupq_n_u8(0x20)), vdupq_n_u8('a'));
+    const uint8x16_t is_digit  = vcleq_u8(digit,  vdupq_n_u8(9));
+    const uint8x16_t is_letter = vcleq_u8(letter, vdupq_n_u8(5));
+    if(vminvq_u8(vorrq_u8(is_digit, is_letter)) != 0xFF) return false;
+
+    const uint8x16_t  nibbles = vbslq_u8(is_digit, digit, vaddq_u8(letter, vdupq_n_u8(10)));
+    const uint8x8x2_t split   = vuzp_u8(vget_low_u8(nibbles), vget_high_u8(nibbles));  //high nibbles, low nibbles
+    vst1_u8(bytes, vorr_u8(vshl_n_u8(split.val[0], 4), split.val[1]));
+    return true;
+#else
+    return decode_hex_scalar(symbols, 8, bytes);
+#endif
+}
+
+//Encodes 0..8 bytes into 2*count symbols.
+inline void encode_hex(const uint8_t* bytes, size_t count, char* symbols)
+{
+    if(count == 8)
+    {
+        encode_hex8(bytes, symbols);
+        return;
+    }
+    encode_hex_scalar(bytes, count, symbols);
+}
+
+//Decodes 2*count symbols into 0..8 bytes; returns false if any of the symbols is not hexadecimal.
+//...a short payload is padded to 16 symbols, so that the vector code never reads beyond the symbols given.
+inline bool decode_hex(const char* symbols, size_t count, uint8_t* bytes)
+{
+    if(count == 8) return decode_hex8(symbols, bytes);
+
+    char padded[16];
+    uint8_t decoded[8];
+    memset(padded, '0', sizeof(padded));
+    memcpy(padded, symbols, 2*count);
+    if(!decode_hex8(padded, decoded)) return false;
+    memcpy(bytes, decoded, count);
+    return true;
+}
+
+} //namespace servosila
+
+#endif // SERVOSILA_HEX_CODEC_H
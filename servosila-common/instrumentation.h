@@ -0,0 +1,256 @@
+/////////////////////////////////////////////////////////////////////////////
+//
+//  This source code comes with Servosila SC-25C Brushless Motor Controllers.
+//  Latency histograms and counters of the receive path: how long a frame
+//  takes from the system call to the end of the application's handler.
+//
+//  The code is provided "AS IS" without any kind of guarantees or warranties.
+//  Use it at your own risk.
+//
+//  The code is free for everyone to use, modify or redistribute.
+//
+//  www.servosila.com
+//
+/////////////////////////////////////////////////////////////////////////////
+
+#ifndef SERVOSILA_INSTRUMENTATION_H
+#define SERVOSILA_INSTRUMENTATION_H
+
+#include "monotonic-clock.h"    //monotonic_ns()
+#include <stddef.h>             //size_t
+#include <stdint.h>             //standard integer types
+#include <atomic>               //lock-free counters, C++11
+#include <ostream>              //dump()
+
+namespace servosila
+{
+
+//The instrumentation is compiled in with DEFINES += SERVOSILA_INSTRUMENTATION in the .pro file...
+//...without it, probe_ns() returns 0 without reading the clock and the receive_path_probe methods are empty,
+//...so the instrumented receive path compiles to the same code as the uninstrumented one.
+#if defined(SERVOSILA_INSTRUMENTATION)
+const bool IS_INSTRUMENTATION_ENABLED = true;
+#else
+const bool IS_INSTRUMENTATION_ENABLED = false;
+#endif
+
+//a timestamp for the instrumentation only; 0 if the instrumentation is compiled out
+inline uint64_t probe_ns()
+{
+    return IS_INSTRUMENTATION_ENABLED ? monotonic_ns() : 0;
+}
+
+//A histogram of latencies with a relative precision of 1/16 (about 6%) from 1ns up to about 36 minutes, in 2.5KB...
+//...every power of two is split into 16 linear sub-buckets, the way HdrHistogram does it, so that
+//...recording is a few shifts and an increment, and percentiles are read without keeping the samples.
+//ATTENTION: one thread records; any thread may read the histogram at the same time, without locks.
+class latency_histogram
+{
+public:
+    static const size_t SUB_BUCKET_BITS  = 4;
+    static const size_t SUB_BUCKET_COUNT = 1 << SUB_BUCKET_BITS;
+    static const size_t MAX_EXPONENT     = 41;  //values from 2^41ns on are counted in the last bucket
+    static const size_t BUCKET_COUNT     = (MAX_EXPONENT - SUB_BUCKET_BITS + 2) * SUB_BUCKET_COUNT;
+
+    latency_histogram()
+    {
+        reset();
+    }
+
+    //the writer only; relaxed loads and stores rather than read-modify-write operations, as there is a single writer
+    void record(uint64_t value_ns)
+    {
+        std::atomic<uint32_t>& count = m_counts[get_bucket(value_ns)];
+        count.store(count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        m_total_count.store(m_total_count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        m_sum_ns.store(m_sum_ns.load(std::memory_order_relaxed) + value_ns, std::memory_order_relaxed);
+        if(value_ns > m_max_ns.load(std::memory_order_relaxed)) m_max_ns.store(value_ns, std::memory_order_relaxed);
+    }
+
+    //the writer only
+    void reset()
+    {
+        for(size_t i=0; i<BUCKET_COUNT; i++) m_counts[i].store(0, std::memory_order_relaxed);
+        m_total_count.store(0, std::memory_order_relaxed);
+        m_sum_ns.store(0, std::memory_order_relaxed);
+        m_max_ns.store(0, std::memory_order_relaxed);
+    }
+
+    uint64_t get_count() const
+    {
+        return m_total_count.load(std::memory_order_relaxed);
+    }
+
+    uint64_t get_max_ns() const
+    {
+        return m_max_ns.load(std::memory_order_relaxed);
+    }
+
+    uint64_t get_mean_ns() const
+    {
+        const uint64_t count = get_count();
+        return (count > 0) ? m_sum_ns.load(std::memory_order_relaxed) / count : 0;
+    }
+
+    //the value that 'fraction' (e.g. 0.999) of the recorded values do not exceed, within the precision of the histogram
+    uint64_t get_percentile_ns(double fraction) const
+    {
+        uint64_t total = 0;
+        for(size_t i=0; i<BUCKET_COUNT; i++) total += m_counts[i].load(std::memory_order_relaxed);
+        if(total == 0) return 0;
+
+        uint64_t target = static_cast<uint64_t>(fraction * static_cast<double>(total) + 0.5);
+        if(target == 0) target = 1;
+        uint64_t count = 0;
+        for(size_t i=0; i<BUCKET_COUNT; i++)
+        {
+            count += m_counts[i].load(std::memory_order_relaxed);
+            if(count >= target)
+            {
+                const uint64_t max_ns = get_max_ns();
+                const uint64_t upper_ns = get_bucket_upper_ns(i);
+                return (upper_ns < max_ns || max_ns == 0) ? upper_ns : max_ns;
+            }
+        }
+        return get_max_ns();
+    }
+
+    //the bucket of a value: the exponent selects a power of two, the next 4 bits the sub-bucket within it
+    static size_t get_bucket(uint64_t value_ns)
+    {
+        if(value_ns < SUB_BUCKET_COUNT) return static_cast<size_t>(value_ns);
+        const size_t exponent = static_cast<size_t>(63 - __builtin_clzll(value_ns));
+        if(exponent > MAX_EXPONENT) return BUCKET_COUNT - 1;
+        const size_t sub_bucket = static_cast<size_t>(value_ns >> (exponent - SUB_BUCKET_BITS)) & (SUB_BUCKET_COUNT - 1);
+        return (exponent - SUB_BUCKET_BITS + 1) * SUB_BUCKET_COUNT + sub_bucket;
+    }
+
+    //the largest value counted in a bucket
+    static uint64_t get_bucket_upper_ns(size_t bucket)
+    {
+        if(bucket < SUB_BUCKET_COUNT) return bucket;
+        const size_t exponent = bucket / SUB_BUCKET_COUNT + SUB_BUCKET_BITS - 1;
+        const uint64_t lower_ns = uint64_t(SUB_BUCKET_COUNT + bucket % SUB_BUCKET_COUNT) << (exponent - SUB_BUCKET_BITS);
+        return lower_ns + (uint64_t(1) << (exponent - SUB_BUCKET_BITS)) - 1;
+    }
+
+private:
+    std::atomic<uint32_t> m_counts[BUCKET_COUNT];
+    std::atomic<uint64_t> m_total_count;
+    std::atomic<uint64_t> m_sum_ns;
+    std::atomic<uint64_t> m_max_ns;
+
+    latency_histogram(const latency_histogram&);            //non-copyable
+    latency_histogram& operator=(const latency_histogram&);
+};
+
+//The stages of the receive path, each with its own latency histogram
+enum receive_stage
+{
+    STAGE_READ,         //a read()/recvmmsg() system call, or receive_many() of a transport
+    STAGE_PARSE,        //SLCAN text to can_messages, per block of text (SocketCAN frames need no parsing)
+    STAGE_DECODE,       //logging and PDO decoding into the telemetry store, per frame
+    STAGE_HANDLER,      //the application's code that reacts to the frame, per frame
+    STAGE_END_TO_END,   //from the time of arrival of the frame to the end of the handler, per frame; with kernel or
+                        //...hardware timestamps (see socketcan::set_timestamping()) this includes the wait in the socket
+    STAGE_COUNT
+};
+
+//The counters of the receive path
+enum receive_counter
+{
+    COUNTER_READS,          //system calls
+    COUNTER_BYTES,          //SLCAN symbols read
+    COUNTER_FRAMES,         //frames received
+    COUNTER_DECODE_ERRORS,  //malformed frames dropped by the decoder
+    COUNTER_DROPPED_FRAMES, //frames dropped by the kernel because the socket's receive queue was full
+    COUNTER_COUNT
+};
+
+//Per-stage latency histograms and counters of a receive path, dumped on request (e.g. on SIGUSR1) or periodically.
+//...The stages are timed with probe_ns() by the receive loop:
+//...    const uint64_t start_ns = servosila::probe_ns();
+//...    ...
+//...    probe.record(servosila::STAGE_DECODE, start_ns, servosila::probe_ns());
+//...All methods do nothing if the instrumentation is compiled out (see IS_INSTRUMENTATION_ENABLED).
+//ATTENTION: one thread records and dumps; other threads may read the histograms and the counters at any time.
+class receive_path_probe
+{
+public:
+    receive_path_probe() : m_previous_dump_ns(0), m_previous_frame_count(0)
+    {
+        for(size_t i=0; i<COUNTER_COUNT; i++) m_counters[i].store(0, std::memory_order_relaxed);
+    }
+
+    void record(receive_stage stage, uint64_t start_ns, uint64_t end_ns)
+    {
+        if(!IS_INSTRUMENTATION_ENABLED) return;
+        m_stages[stage].record(end_ns - start_ns);
+    }
+
+    void add(receive_counter counter, uint64_t value)
+    {
+        if(!IS_INSTRUMENTATION_ENABLED) return;
+        m_counters[counter].store(m_counters[counter].load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+    }
+
+    //for the counters that the source keeps by itself, e.g. slcan_buffer_decoder::get_error_count()
+    void set(receive_counter counter, uint64_t value)
+    {
+        if(!IS_INSTRUMENTATION_ENABLED) return;
+        m_counters[counter].store(value, std::memory_order_relaxed);
+    }
+
+    const latency_histogram& get_histogram(receive_stage stage) const
+    {
+        return m_stages[stage];
+    }
+
+    uint64_t get_counter(receive_counter counter) const
+    {
+        return m_counters[counter].load(std::memory_order_relaxed);
+    }
+
+    //Prints out the counters, the frame rate since the previous dump, and the percentiles of every stage that has been timed...
+    //...the histograms are reset, so that every dump covers the period since the previous one; the counters keep counting.
+    void dump(std::ostream& output)
+    {
+        if(!IS_INSTRUMENTATION_ENABLED) return;
+        static const char* const STAGE_NAMES[STAGE_COUNT] = { "read", "parse", "decode", "handler", "end-to-end" };
+
+        const uint64_t now_ns = monotonic_ns();
+        const uint64_t frame_count = get_counter(COUNTER_FRAMES);
+        output<<"Reads: "<<get_counter(COUNTER_READS)<<" bytes: "<<get_counter(COUNTER_BYTES)<<" frames: "<<frame_count
+              <<" decode errors: "<<get_counter(COUNTER_DECODE_ERRORS)<<" dropped: "<<get_counter(COUNTER_DROPPED_FRAMES);
+        if(m_previous_dump_ns != 0 && now_ns > m_previous_dump_ns)
+        {
+            output<<" rate: "<<(frame_count - m_previous_frame_count) * 1000000000ull / (now_ns - m_previous_dump_ns)<<" frames/s";
+        }
+        output<<'\n';
+        m_previous_dump_ns = now_ns;
+        m_previous_frame_count = frame_count;
+
+        for(size_t i=0; i<STAGE_COUNT; i++)
+        {
+            latency_histogram& h = m_stages[i];
+            if(h.get_count() == 0) continue;
+            output<<"  "<<STAGE_NAMES[i]<<": count "<<h.get_count()<<" mean "<<h.get_mean_ns()<<" p50 "<<h.get_percentile_ns(0.5)
+                  <<" p99 "<<h.get_percentile_ns(0.99)<<" p99.9 "<<h.get_percentile_ns(0.999)<<" max "<<h.get_max_ns()<<" ns"<<'\n';
+            h.reset();
+        }
+        output<<std::flush;
+    }
+
+private:
+    latency_histogram     m_stages[STAGE_COUNT];
+    std::atomic<uint64_t> m_counters[COUNTER_COUNT];
+    uint64_t              m_previous_dump_ns;
+    uint64_t              m_previous_frame_count;
+
+    receive_path_probe(const receive_path_probe&);            //non-copyable
+    receive_path_probe& operator=(const receive_path_probe&);
+};
+
+} //namespace servosila
+
+#endif // SERVOSILA_INSTRUMENTATION_H
@@ -0,0 +1,290 @@
+/////////////////////////////////////////////////////////////////////////////
+//
+//  This source code comes with Servosila SC-25C Brushless Motor Controllers.
+//  A watchdog that notices when the telemetry of a controller goes quiet
+//  or when its period drifts, with a jitter histogram per controller.
+//
+//  The code is provided "AS IS" without any kind of guarantees or warranties.
+//  Use it at your own risk.
+//
+//  The code is free for everyone to use, modify or redistribute.
+//
+//  www.servosila.com
+//
+/////////////////////////////////////////////////////////////////////////////
+
+#ifndef SERVOSILA_LIVENESS_WATCHDOG_H
+#define SERVOSILA_LIVENESS_WATCHDOG_H
+
+#include <stddef.h>     //size_t
+#include <stdint.h>     //standard integer types
+#include <string.h>     //memset()
+
+namespace servosila
+{
+
+//The state of the telemetry of a controller
+enum liveness_state
+{
+    LIVENESS_UNKNOWN,   //no telemetry yet, or the period is still being learned
+    LIVENESS_ALIVE,     //the telemetry comes at its nominal period
+    LIVENESS_DRIFTING,  //the average period is off the nominal one, e.g. because the CAN bus is congested
+    LIVENESS_SILENT     //no telemetry for several periods; the controller is off, disconnected or hung
+};
+
+//Arrival statistics of the telemetry of a controller
+struct liveness_stats
+{
+    //Jitter histogram: the deviation of every interval between two messages from the nominal period...
+    //...bucket 0 counts deviations under 1us, bucket N counts deviations of [2^(N-1), 2^N) us; the last bucket counts the rest.
+    static const size_t JITTER_BUCKET_COUNT = 16;
+    uint32_t jitter[JITTER_BUCKET_COUNT];
+
+    uint64_t nominal_period_ns;     //set with set_period(), or learned from the first intervals
+    uint64_t average_period_ns;     //the moving average of the intervals
+    uint64_t max_interval_ns;       //the longest interval seen
+    uint32_t interval_count;
+    uint32_t silence_count;         //how many times the controller has gone silent
+};
+
+//The watchdog is fed with the arrival times of one of the periodic telemetry messages of every controller (e.g. 0x180)...
+//...and is advanced by a periodic timer of the same thread, e.g. every 10ms.
+//...The deadlines of the controllers are kept in a timer wheel: slots of 1ms (2^20ns), each holding an intrusive list of
+//...the controllers whose deadline falls into it. An arrival moves a controller to a new slot and a timer tick visits
+//...only the slots that have passed since the previous tick, so both cost the same for 1 controller and for 127.
+//'Handler' is any callable 'void(uint32_t node_id, liveness_state state)', called when the state of a controller changes.
+//ATTENTION: the watchdog is not thread-safe; feed it and advance it from the thread that receives the telemetry.
+class liveness_watchdog
+{
+public:
+    static const uint32_t MAX_NODE_ID = 127;
+
+    liveness_watchdog()
+        : m_current_tick(0),
+          m_initial_timeout_ns(100000000ull),   //100ms, until the period is known
+          m_min_timeout_ns(20000000ull),        //20ms
+          m_silence_periods(5),
+          m_drift_percent(20)
+    {
+        memset(m_nodes, 0, sizeof(m_nodes));
+        for(uint32_t node_id=0; node_id<=MAX_NODE_ID; node_id++) m_nodes[node_id].slot = NIL;
+        for(size_t i=0; i<SLOT_COUNT; i++) m_slots[i] = NIL;
+    }
+
+    //the nominal period of the telemetry of a controller, e.g. as configured in the controller...
+    //...with 0 (the default) the period is learned from the first intervals.
+    void set_period(uint32_t node_id, uint64_t period_ns)
+    {
+        if(node_id > MAX_NODE_ID) return;
+        node& n = m_nodes[node_id];
+        n.stats.nominal_period_ns = period_ns;
+        n.is_period_fixed = (period_ns != 0);
+    }
+
+    //A controller is silent after 'silence_periods' nominal periods without telemetry, but not sooner than 'min_timeout_ns';
+    //...it is drifting when the average period is off the nominal one by more than 'drift_percent'.
+    void set_tolerances(uint32_t silence_periods, uint64_t min_timeout_ns, uint32_t drift_percent)
+    {
+        m_silence_periods = silence_periods;
+        m_min_timeout_ns  = min_timeout_ns;
+        m_drift_percent   = drift_percent;
+    }
+
+    //Receive path: 'timestamp_ns' is the monotonic_ns() time of arrival of a telemetry message of the controller
+    template<typename Handler>
+    void on_arrival(uint32_t node_id, uint64_t timestamp_ns, Handler handler)
+    {
+        if(node_id == 0 || node_id > MAX_NODE_ID) return;
+        node& n = m_nodes[node_id];
+        liveness_stats& s = n.stats;
+        const liveness_state previous_state = n.state;
+
+        if(n.last_arrival_ns != 0 && previous_state != LIVENESS_SILENT && timestamp_ns > n.last_arrival_ns)
+        {
+            const uint64_t interval_ns = timestamp_ns - n.last_arrival_ns;
+            if(interval_ns > s.max_interval_ns) s.max_interval_ns = interval_ns;
+            s.interval_count++;
+
+            //a moving average over ~16 intervals: one late message does not make the controller drift
+            if(s.average_period_ns == 0) s.average_period_ns = interval_ns;
+            else s.average_period_ns = s.average_period_ns - s.average_period_ns / 16 + interval_ns / 16;
+
+            if(!n.is_period_fixed && s.interval_count == LEARNING_INTERVALS) s.nominal_period_ns = s.average_period_ns;
+
+            if(s.nominal_period_ns != 0)
+            {
+                const uint64_t deviation_ns = (interval_ns > s.nominal_period_ns) ? (interval_ns - s.nominal_period_ns) : (s.nominal_period_ns - interval_ns);
+                s.jitter[jitter_bucket(deviation_ns)]++;
+
+                //the state goes back from drifting to alive at half the tolerance, so that it does not flicker at the border
+                const uint64_t drift_ns = (s.average_period_ns > s.nominal_period_ns) ? (s.average_period_ns - s.nominal_period_ns) : (s.nominal_period_ns - s.average_period_ns);
+                const uint64_t tolerance_ns = s.nominal_period_ns * m_drift_percent / 100;
+                if(drift_ns > tolerance_ns) n.state = LIVENESS_DRIFTING;
+                else if(n.state != LIVENESS_DRIFTING || drift_ns <= tolerance_ns / 2) n.state = LIVENESS_ALIVE;
+            }
+        }
+        else if(previous_state == LIVENESS_SILENT)
+        {   //the controller is back; the intervals are counted from this message on
+            n.state = (s.nominal_period_ns != 0 && s.interval_count >= LEARNING_INTERVALS) ? LIVENESS_ALIVE : LIVENESS_UNKNOWN;
+        }
+        n.last_arrival_ns = timestamp_ns;
+
+        //re-arming the deadline of the controller...
+        //...the wheel starts at the first arrival if it has not been advanced yet: the first advance() then visits
+        //...the slots from here on, rather than starting at its own time and skipping the deadlines that are due already.
+        if(m_current_tick == 0) m_current_tick = timestamp_ns >> TICK_SHIFT;
+        unlink(node_id);
+        uint64_t timeout_ns = (s.nominal_period_ns != 0) ? s.nominal_period_ns * m_silence_periods : m_initial_timeout_ns;
+        if(timeout_ns < m_min_timeout_ns) timeout_ns = m_min_timeout_ns;
+        n.deadline_ns = timestamp_ns + timeout_ns;
+        link(node_id);
+
+        if(n.state != previous_state) handler(node_id, n.state);
+    }
+
+    //Timer path: flags the controllers whose deadline has passed as silent; returns the number of controllers flagged
+    template<typename Handler>
+    size_t advance(uint64_t now_ns, Handler handler)
+    {
+        const uint64_t now_tick = now_ns >> TICK_SHIFT;
+        if(m_current_tick == 0) m_current_tick = now_tick;
+        if(now_tick <= m_current_tick) return 0;
+
+        //visiting every slot that has passed since the previous call, but each slot at most once...
+        //...the slot of the previous call is visited again, as its later deadlines were not due yet at the time.
+        const uint64_t tick_count = (now_tick - m_current_tick < SLOT_COUNT) ? (now_tick - m_current_tick) : (SLOT_COUNT - 1);
+        size_t nsilent = 0;
+        for(uint64_t tick=now_tick-tick_count; tick<=now_tick; tick++)
+        {
+            int16_t node_id = m_slots[tick & SLOT_MASK];
+            while(node_id != NIL)
+            {
+                node& n = m_nodes[node_id];
+                const int16_t next = n.next;
+                //a deadline more than a turn of the wheel away stays in its slot for a later turn
+                if(n.deadline_ns <= now_ns)
+                {
+                    unlink(static_cast<uint32_t>(node_id));
+                    n.state = LIVENESS_SILENT;
+                    n.stats.silence_count++;
+                    nsilent++;
+                    handler(static_cast<uint32_t>(node_id), LIVENESS_SILENT);
+                }
+                node_id = next;
+            }
+        }
+        m_current_tick = now_tick;
+        return nsilent;
+    }
+
+    liveness_state get_state(uint32_t node_id) const
+    {
+        return (node_id <= MAX_NODE_ID) ? m_nodes[node_id].state : LIVENESS_UNKNOWN;
+    }
+
+    const liveness_stats& get_stats(uint32_t node_id) const
+    {
+        return m_nodes[(node_id <= MAX_NODE_ID) ? node_id : 0].stats;
+    }
+
+    //the deviation from the nominal period that 'fraction' (e.g. 0.99) of the intervals do not exceed...
+    //...the upper bound of the histogram bucket, in nanoseconds; 0 if there are no intervals yet.
+    uint64_t get_jitter_percentile_ns(uint32_t node_id, double fraction) const
+    {
+        const liveness_stats& s = get_stats(node_id);
+        uint64_t total = 0;
+        for(size_t i=0; i<liveness_stats::JITTER_BUCKET_COUNT; i++) total += s.jitter[i];
+        if(total == 0) return 0;
+
+        const uint64_t target = static_cast<uint64_t>(fraction * static_cast<double>(total) + 0.5);
+        uint64_t count = 0;
+        for(size_t i=0; i<liveness_stats::JITTER_BUCKET_COUNT; i++)
+        {
+            count += s.jitter[i];
+            if(count >= target) return (uint64_t(1) << i) * 1000;
+        }
+        return (uint64_t(1) << (liveness_stats::JITTER_BUCKET_COUNT - 1)) * 1000;
+    }
+
+    //forgets the statistics of all controllers; the nominal periods are kept
+    void reset_stats()
+    {
+        for(uint32_t node_id=0; node_id<=MAX_NODE_ID; node_id++)
+        {
+            liveness_stats& s = m_nodes[node_id].stats;
+            const uint64_t nominal_period_ns = s.nominal_period_ns;
+            const uint64_t average_period_ns = s.average_period_ns;
+            const uint32_t interval_count = (s.interval_count < LEARNING_INTERVALS) ? s.interval_count : LEARNING_INTERVALS;
+            memset(&s, 0, sizeof(s));
+            s.nominal_period_ns = nominal_period_ns;
+            s.average_period_ns = average_period_ns;
+            s.interval_count    = interval_count;   //the learning of the period is not restarted
+        }
+    }
+
+private:
+    static const uint32_t TICK_SHIFT = 20;              //a slot is 2^20ns, about 1ms
+    static const size_t   SLOT_COUNT = 256;             //a turn of the wheel is about 268ms
+    static const size_t   SLOT_MASK  = SLOT_COUNT - 1;
+    static const int16_t  NIL        = -1;
+    static const uint32_t LEARNING_INTERVALS = 16;
+
+    struct node
+    {
+        liveness_stats stats;
+        uint64_t       last_arrival_ns;
+        uint64_t       deadline_ns;
+        liveness_state state;
+        int16_t        prev;            //neighbours in the list of the slot
+        int16_t        next;
+        int16_t        slot;            //NIL if the controller is not in the wheel
+        bool           is_period_fixed;
+    };
+
+    node     m_nodes[MAX_NODE_ID + 1];
+    int16_t  m_slots[SLOT_COUNT];       //the first controller in the list of every slot
+    uint64_t m_current_tick;            //the tick of the previous advance(), or of the first arrival; 0 before either
+    uint64_t m_initial_timeout_ns;
+    uint64_t m_min_timeout_ns;
+    uint32_t m_silence_periods;
+    uint32_t m_drift_percent;
+
+    static size_t jitter_bucket(uint64_t deviation_ns)
+    {
+        const uint64_t deviation_us = deviation_ns / 1000;
+        if(deviation_us == 0) return 0;
+        const size_t bucket = static_cast<size_t>(64 - __builtin_clzll(deviation_us));  //the number of significant bits
+        return (bucket < liveness_stats::JITTER_BUCKET_COUNT) ? bucket : (liveness_stats::JITTER_BUCKET_COUNT - 1);
+    }
+
+    void link(uint32_t node_id)
+    {
+        node& n = m_nodes[node_id];
+        //a deadline that is already due goes into the next slot to be visited, not a whole turn later
+        uint64_t tick = n.deadline_ns >> TICK_SHIFT;
+        if(tick <= m_current_tick) tick = m_current_tick + 1;
+
+        n.slot = static_cast<int16_t>(tick & SLOT_MASK);
+        n.prev = NIL;
+        n.next = m_slots[n.slot];
+        if(n.next != NIL) m_nodes[n.next].prev = static_cast<int16_t>(node_id);
+        m_slots[n.slot] = static_cast<int16_t>(node_id);
+    }
+
+    void unlink(uint32_t node_id)
+    {
+        node& n = m_nodes[node_id];
+        if(n.slot == NIL) return;
+        if(n.prev != NIL) m_nodes[n.prev].next = n.next;
+        else m_slots[n.slot] = n.next;
+        if(n.next != NIL) m_nodes[n.next].prev = n.prev;
+        n.slot = NIL;
+    }
+
+    liveness_watchdog(const liveness_watchdog&);            //non-copyable
+    liveness_watchdog& operator=(const liveness_watchdog&);
+};
+
+} //namespace servosila
+
+#endif // SERVOSILA_LIVENESS_WATCHDOG_H
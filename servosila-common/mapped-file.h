@@ -0,0 +1,97 @@
+/////////////////////////////////////////////////////////////////////////////
+//
+//  This source code comes with Servosila SC-25C Brushless Motor Controllers.
+//  A read-only memory-mapped file.
+//      OS: Linux
+//
+//  The code is provided "AS IS" without any kind of guarantees or warranties.
+//  Use it at your own risk.
+//
+//  The code is free for everyone to use, modify or redistribute.
+//
+//  www.servosila.com
+//
+/////////////////////////////////////////////////////////////////////////////
+
+#ifndef SERVOSILA_MAPPED_FILE_H
+#define SERVOSILA_MAPPED_FILE_H
+
+#include <stddef.h>         //size_t
+#include <fcntl.h>          //open()
+#include <unistd.h>         //close()
+#include <sys/mman.h>       //mmap(), munmap(), madvise()
+#include <sys/stat.h>       //fstat()
+
+namespace servosila
+{
+
+//Maps a whole file into memory, so that recorded CAN traffic can be decoded straight from the page cache
+//...without copying it through read() buffers.
+class mapped_file
+{
+public:
+    mapped_file() : m_data(nullptr), m_size(0) {}
+    ~mapped_file() { close(); }
+
+    bool open(const char* file_name)
+    {
+        close();
+
+        const int file = ::open(file_name, O_RDONLY | O_CLOEXEC);
+        if(file < 0) return false;
+
+        struct stat file_stat;
+        if(::fstat(file, &file_stat) < 0 || file_stat.st_size <= 0)
+        {
+            ::close(file);
+            return false;
+        }
+
+        void* data = ::mmap(nullptr, static_cast<size_t>(file_stat.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+        ::close(file);  //the mapping stays valid after the descriptor is closed
+        if(data == MAP_FAILED) return false;
+
+        //the file is going to be read from the beginning to the end; asking the kernel to read ahead aggressively
+        ::madvise(data, static_cast<size_t>(file_stat.st_size), MADV_SEQUENTIAL);
+
+        m_data = static_cast<const char*>(data);
+        m_size = static_cast<size_t>(file_stat.st_size);
+        return true;
+    }
+
+    void close()
+    {
+        if(m_data != nullptr)
+        {
+            ::munmap(const_cast<char*>(m_data), m_size);
+            m_data = nullptr;
+            m_size = 0;
+        }
+    }
+
+    bool is_open() const
+    {
+        return m_data != nullptr;
+    }
+
+    const char* data() const
+    {
+        return m_data;
+    }
+
+    size_t size() const
+    {
+        return m_size;
+    }
+
+private:
+    const char* m_data;
+    size_t      m_size;
+
+    mapped_file(const mapped_file&);            //non-copyable
+    mapped_file& operator=(const mapped_file&);
+};
+
+} //namespace servosila
+
+#endif // SERVOSILA_MAPPED_FILE_H
@@ -0,0 +1,162 @@
+/////////////////////////////////////////////////////////////////////////////
+//
+//  This source code comes with Servosila SC-25C Brushless Motor Controllers.
+//  An in-memory CAN bus with the same interface as servosila::socketcan,
+//  for running the samples against recorded or simulated traffic.
+//      OS: Linux
+//
+//  The code is provided "AS IS" without any kind of guarantees or warranties.
+//  Use it at your own risk.
+//
+//  The code is free for everyone to use, modify or redistribute.
+//
+//  www.servosila.com
+//
+/////////////////////////////////////////////////////////////////////////////
+
+#ifndef SERVOSILA_MEMORY_TRANSPORT_H
+#define SERVOSILA_MEMORY_TRANSPORT_H
+
+#include "can-message.h"
+#include "can-id-filter.h"
+#include "spsc-queue.h"         //lock-free queues of frames
+#include "monotonic-clock.h"    //monotonic_ns()
+#include <stddef.h>             //size_t
+#include <stdint.h>             //standard integer types
+#include <atomic>               //drop counter, C++11
+#include <sys/eventfd.h>        //eventfd()
+#include <unistd.h>             //read(), write(), close()
+
+namespace servosila
+{
+
+//A virtual CAN bus in memory: the other side of the bus (a replay, a simulator or a test, on any thread) injects frames
+//...with inject() and takes the frames the application has sent with take_sent().
+//...An eventfd stands in for the socket, so that the main loop waits for injected frames with epoll as for real ones.
+//ATTENTION: inject() and take_sent() are called from one thread; the other methods from the application's thread.
+class memory_transport
+{
+public:
+    explicit memory_transport(size_t capacity = 4096)
+        : m_received(capacity), m_sent(capacity), m_event(-1), m_dropped_count(0) {}
+    ~memory_transport() { shutdown(); }
+
+    //the name is ignored; the bus is created empty
+    bool startup(const char* network_name = nullptr)
+    {
+        (void)network_name;
+        shutdown();
+        m_event = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        return m_event >= 0;
+    }
+
+    void shutdown()
+    {
+        if(m_event >= 0)
+        {
+            ::close(m_event);
+            m_event = -1;
+        }
+    }
+
+    bool is_connected() const
+    {
+        return m_event >= 0;
+    }
+
+    //the descriptor to be waited on; it becomes readable when frames are injected
+    int get_socket() const
+    {
+        return m_event;
+    }
+
+    //the frames rejected by the filter are dropped by inject(), the way the kernel drops them for SocketCAN
+    bool set_filter(const can_id_filter& filter)
+    {
+        m_filter = filter;
+        return true;
+    }
+
+    //the frames are stamped as they are received
+    bool set_timestamping(rx_timestamp_source source)
+    {
+        return source == TIMESTAMP_RECEIVE;
+    }
+
+    rx_timestamp_source get_timestamp_source() const
+    {
+        return TIMESTAMP_RECEIVE;
+    }
+
+    //receives up to 'count' injected frames; returns the number of frames written to 'messages'
+    size_t receive_many(can_message* messages, size_t count)
+    {
+        return receive_many(messages, nullptr, count);
+    }
+
+    //same as above; the time of arrival of every frame is written to 'timestamps_ns'
+    size_t receive_many(can_message* messages, uint64_t* timestamps_ns, size_t count)
+    {
+        //clearing the event first: a frame injected from now on wakes the main loop up again
+        uint64_t value = 0;
+        if(::read(m_event, &value, sizeof(value)) < 0) { /*nothing injected since the previous call*/ }
+        const size_t nreceived = m_received.pop_many(messages, count);
+
+        if(timestamps_ns != nullptr)
+        {
+            const uint64_t receive_ns = monotonic_ns();
+            for(size_t i=0; i<nreceived; i++) timestamps_ns[i] = receive_ns;
+        }
+        return nreceived;
+    }
+
+    //queues up to 'count' frames for take_sent(); returns the number of frames queued
+    size_t send_many(const can_message* messages, size_t count)
+    {
+        size_t nsent = 0;
+        while(nsent < count && m_sent.try_push(messages[nsent])) nsent++;
+        return nsent;
+    }
+
+    //how many injected frames have been dropped because the application did not receive them fast enough
+    uint32_t get_dropped_count() const
+    {
+        return m_dropped_count.load(std::memory_order_relaxed);
+    }
+
+    //The other side of the bus: delivers frames to the application; returns the number of frames that passed the filter
+    size_t inject(const can_message* messages, size_t count)
+    {
+        size_t ninjected = 0;
+        for(size_t i=0; i<count; i++)
+        {
+            if(!m_filter.accepts(messages[i].can_id)) continue;
+            if(m_received.try_push(messages[i])) ninjected++;
+            else m_dropped_count.store(m_dropped_count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        }
+
+        const uint64_t value = 1;
+        if(ninjected > 0 && ::write(m_event, &value, sizeof(value)) < 0) { /*the event is already pending*/ }
+        return ninjected;
+    }
+
+    //The other side of the bus: takes up to 'count' frames sent by the application; returns the number of frames taken
+    size_t take_sent(can_message* messages, size_t count)
+    {
+        return m_sent.pop_many(messages, count);
+    }
+
+private:
+    spsc_queue<can_message> m_received;     //injected -> receive_many()
+    spsc_queue<can_message> m_sent;         //send_many() -> take_sent()
+    can_id_filter           m_filter;
+    int                     m_event;
+    std::atomic<uint32_t>   m_dropped_count;
+
+    memory_transport(const memory_transport&);              //non-copyable
+    memory_transport& operator=(const memory_transport&);
+};
+
+} //namespace servosila
+
+#endif // SERVOSILA_MEMORY_TRANSPORT_H
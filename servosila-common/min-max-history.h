@@ -0,0 +1,132 @@
+/////////////////////////////////////////////////////////////////////////////
+//
+//  This source code comes with Servosila SC-25C Brushless Motor Controllers.
+//  A fixed-size history of a telemetry value, decimated to min/max pairs
+//  for plotting.
+//
+//  The code is provided "AS IS" without any kind of guarantees or warranties.
+//  Use it at your own risk.
+//
+//  The code is free for everyone to use, modify or redistribute.
+//
+//  www.servosila.com
+//
+/////////////////////////////////////////////////////////////////////////////
+
+#ifndef SERVOSILA_MIN_MAX_HISTORY_H
+#define SERVOSILA_MIN_MAX_HISTORY_H
+
+#include <stddef.h>     //size_t
+#include <stdint.h>     //standard integer types
+#include <vector>       //preallocated ring buffer
+
+namespace servosila
+{
+
+//The history is a ring buffer of time buckets of equal duration, e.g. 2048 buckets of 5ms cover the latest 10 seconds.
+//...A sample only updates the minimum and the maximum of its bucket, so memory does not grow with the telemetry rate,
+//...and drawing the history costs the same whether the telemetry comes at 10Hz or at 10kHz.
+//...The min/max pairs keep spikes visible that averaging or picking every Nth sample would hide.
+//ATTENTION: the history is not thread-safe; fill it and draw it from the same thread.
+class min_max_history
+{
+public:
+    //a vertical strip of a plot: the range of the values of the buckets merged into it
+    struct column
+    {
+        float minimum;
+        float maximum;
+        bool  is_valid;     //false if no samples fell into the column
+    };
+
+    explicit min_max_history(size_t bucket_count = 2048, uint64_t bucket_ns = 5000000ull)
+        : m_buckets(bucket_count), m_bucket_ns(bucket_ns), m_newest(0)
+    {
+        clear();
+    }
+
+    void clear()
+    {
+        for(size_t i=0; i<m_buckets.size(); i++) m_buckets[i].number = INVALID_NUMBER;
+        m_newest = 0;
+    }
+
+    //adds a sample; 'timestamp_ns' is monotonic_ns() time...
+    //...the samples may come slightly out of order; a sample older than the whole history is ignored.
+    void add(uint64_t timestamp_ns, float value)
+    {
+        const uint64_t number = timestamp_ns / m_bucket_ns;
+        if(number + m_buckets.size() <= m_newest) return;
+        if(number > m_newest) m_newest = number;
+
+        bucket& b = m_buckets[number % m_buckets.size()];
+        if(b.number != number)
+        {   //the first sample of a bucket; the slot held a bucket that has fallen out of the history
+            b.number  = number;
+            b.minimum = value;
+            b.maximum = value;
+            return;
+        }
+        if(value < b.minimum) b.minimum = value;
+        if(value > b.maximum) b.maximum = value;
+    }
+
+    //Merges the whole history, which ends at 'end_ns', into 'column_count' columns, the oldest column first,
+    //...e.g. one column per pixel of a plot. The cost is proportional to the number of buckets, not of samples.
+    void decimate(uint64_t end_ns, column* columns, size_t column_count) const
+    {
+        const size_t bucket_count = m_buckets.size();
+        const uint64_t end_number = end_ns / m_bucket_ns + 1;   //one past the newest bucket shown
+        const uint64_t begin_number = (end_number > bucket_count) ? (end_number - bucket_count) : 0;
+
+        for(size_t c=0; c<column_count; c++)
+        {
+            column& col = columns[c];
+            col.is_valid = false;
+
+            //the buckets that fall into this column; a column gets at least one bucket when zoomed in
+            const uint64_t first = begin_number + (static_cast<uint64_t>(c) * bucket_count) / column_count;
+            uint64_t last = begin_number + (static_cast<uint64_t>(c + 1) * bucket_count) / column_count;
+            if(last == first) last = first + 1;
+
+            for(uint64_t number=first; number<last; number++)
+            {
+                const bucket& b = m_buckets[number % bucket_count];
+                if(b.number != number) continue;    //no samples in this bucket
+                if(!col.is_valid)
+                {
+                    col.minimum  = b.minimum;
+                    col.maximum  = b.maximum;
+                    col.is_valid = true;
+                    continue;
+                }
+                if(b.minimum < col.minimum) col.minimum = b.minimum;
+                if(b.maximum > col.maximum) col.maximum = b.maximum;
+            }
+        }
+    }
+
+    //the time span of the history
+    uint64_t get_duration_ns() const
+    {
+        return m_buckets.size() * m_bucket_ns;
+    }
+
+private:
+    static const uint64_t INVALID_NUMBER = ~0ull;
+
+    struct bucket
+    {
+        uint64_t number;    //timestamp_ns / bucket_ns of the samples in the bucket; tells a current bucket from a stale one
+        float    minimum;
+        float    maximum;
+    };
+
+    std::vector<bucket> m_buckets;
+    uint64_t            m_bucket_ns;
+    uint64_t            m_newest;   //the number of the newest bucket
+};
+
+} //namespace servosila
+
+#endif // SERVOSILA_MIN_MAX_HISTORY_H
@@ -0,0 +1,37 @@
+/////////////////////////////////////////////////////////////////////////////
+//
+//  This source code comes with Servosila SC-25C Brushless Motor Controllers.
+//  The time base shared by telemetry timestamps, logs and statistics.
+//      OS: Linux
+//
+//  The code is provided "AS IS" without any kind of guarantees or warranties.
+//  Use it at your own risk.
+//
+//  The code is free for everyone to use, modify or redistribute.
+//
+//  www.servosila.com
+//
+/////////////////////////////////////////////////////////////////////////////
+
+#ifndef SERVOSILA_MONOTONIC_CLOCK_H
+#define SERVOSILA_MONOTONIC_CLOCK_H
+
+#include <stdint.h>     //standard integer types
+#include <time.h>       //clock_gettime()
+
+namespace servosila
+{
+
+//Returns CLOCK_MONOTONIC time in nanoseconds.
+//...the clock does not jump when the system time is set, so differences between two readings are always valid.
+//...on Linux the call is served by vDSO and does not enter the kernel.
+inline uint64_t monotonic_ns()
+{
+    struct timespec ts;
+    ::clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000ull + static_cast<uint64_t>(ts.tv_nsec);
+}
+
+} //namespace servosila
+
+#endif // SERVOSILA_MONOTONIC_CLOCK_H
@@ -0,0 +1,265 @@
+/////////////////////////////////////////////////////////////////////////////
+//
+//  This source code comes with Servosila SC-25C Brushless Motor Controllers.
+//  A fixed-rate loop for control cycles: absolute deadlines, SCHED_FIFO,
+//  CPU pinning and locked memory, with overrun and jitter statistics.
+//      OS: Linux
+//
+//  The code is provided "AS IS" without any kind of guarantees or warranties.
+//  Use it at your own risk.
+//
+//  The code is free for everyone to use, modify or redistribute.
+//
+//  www.servosila.com
+//
+/////////////////////////////////////////////////////////////////////////////
+
+#ifndef SERVOSILA_REALTIME_LOOP_H
+#define SERVOSILA_REALTIME_LOOP_H
+
+#include "instrumentation.h"    //latency_histogram
+#include "event-loop.h"         //run_event_loop()
+#include "monotonic-clock.h"    //monotonic_ns()
+#include <stddef.h>             //size_t
+#include <stdint.h>             //standard integer types
+#include <string.h>             //memset()
+#include <errno.h>              //EINTR
+#include <time.h>               //clock_nanosleep()
+#include <alloca.h>             //alloca()
+#include <malloc.h>             //mallopt()
+#include <unistd.h>             //sysconf()
+#include <pthread.h>            //pthread_setaffinity_np(), pthread_setschedparam()
+#include <sched.h>              //SCHED_FIFO, cpu_set_t
+#include <sys/mman.h>           //mlockall()
+#include <atomic>               //stop flag and counters, C++11
+#include <ostream>              //dump()
+
+namespace servosila
+{
+
+//How the thread of a real-time loop is set up; the defaults need no privileges
+struct realtime_config
+{
+    uint64_t period_ns;         //the cycle
+    int      priority;          //SCHED_FIFO priority 1..99; 0 keeps the normal scheduling
+    int      cpu;               //the CPU the thread is pinned to, ideally one isolated with isolcpus=; -1 for any CPU
+    bool     is_memory_locked;  //mlockall(): no page faults once the loop runs
+    size_t   stack_size;        //bytes of stack touched in advance, so that deep calls in the cycle do not fault; 0 for none
+
+    explicit realtime_config(uint64_t period = 1000000ull)     //1ms
+        : period_ns(period), priority(0), cpu(-1), is_memory_locked(true), stack_size(256 * 1024) {}
+};
+
+//Runs a cycle at a fixed rate on the calling thread, for control loops that must not drift or stall:
+//...- the thread sleeps with clock_nanosleep() until an absolute deadline, so the time spent in the cycle
+//...  does not shift the next one, and the wake-up does not wait for the timer slack of a relative sleep;
+//...- a cycle that runs past the next deadline is an overrun; the deadlines that have passed are skipped
+//...  rather than run back to back, so the following cycles stay on the original grid;
+//...- the lateness of every wake-up (the jitter) and the duration of every cycle are recorded in histograms.
+//SCHED_FIFO and mlockall() need privileges: root, or CAP_SYS_NICE and CAP_IPC_LOCK, or rtprio and memlock
+//...limits in /etc/security/limits.conf. setup() reports what it could not apply; the loop runs in any case.
+//The cycle does not block: it polls the descriptors without waiting, e.g. with event_loop::run_pending().
+//ATTENTION: one thread sets up, runs and dumps the loop; stop() and the statistics may be used from any thread.
+class realtime_loop
+{
+public:
+    realtime_loop()
+        : m_period_ns(realtime_config().period_ns), m_is_running(false),
+          m_is_memory_locked(false), m_is_pinned(false), m_is_fifo(false)
+    {
+        reset_stats();
+    }
+
+    //Sets the calling thread up; returns false if any of the requested settings could not be applied
+    bool setup(const realtime_config& config)
+    {
+        m_period_ns = (config.period_ns > 0) ? config.period_ns : realtime_config().period_ns;
+        bool is_complete = true;
+
+        if(config.is_memory_locked)
+        {
+            //the heap is neither trimmed nor served by mmap(), so that the memory once locked stays with the process
+            ::mallopt(M_TRIM_THRESHOLD, -1);
+            ::mallopt(M_MMAP_MAX, 0);
+            m_is_memory_locked = (::mlockall(MCL_CURRENT | MCL_FUTURE) == 0);
+            is_complete = is_complete && m_is_memory_locked;
+        }
+        //after mlockall(): the pages touched now stay resident
+        if(config.stack_size > 0) prefault_stack(config.stack_size);
+
+        if(config.cpu >= 0)
+        {
+            cpu_set_t cpus;
+            CPU_ZERO(&cpus);
+            CPU_SET(config.cpu, &cpus);
+            m_is_pinned = (::pthread_setaffinity_np(::pthread_self(), sizeof(cpus), &cpus) == 0);
+            is_complete = is_complete && m_is_pinned;
+        }
+
+        if(config.priority > 0)
+        {
+            struct sched_param param;
+            memset(&param, 0, sizeof(param));
+            param.sched_priority = config.priority;
+            m_is_fifo = (::pthread_setschedparam(::pthread_self(), SCHED_FIFO, &param) == 0);
+            is_complete = is_complete && m_is_fifo;
+        }
+        return is_complete;
+    }
+
+    bool is_memory_locked() const { return m_is_memory_locked; }
+    bool is_pinned()        const { return m_is_pinned;        }
+    bool is_fifo()          const { return m_is_fifo;          }
+
+    uint64_t get_period_ns() const
+    {
+        return m_period_ns;
+    }
+
+    //Calls 'cycle' once per period until stop() is called or 'cycle' returns false...
+    //...'cycle' is any callable 'bool(uint64_t deadline_ns)'; 'deadline_ns' is the monotonic_ns() time the cycle was due.
+    template<typename Cycle>
+    void run(Cycle&& cycle)
+    {
+        m_is_running.store(true, std::memory_order_relaxed);
+        uint64_t deadline_ns = monotonic_ns() + m_period_ns;
+        while(m_is_running.load(std::memory_order_relaxed))
+        {
+            sleep_until(deadline_ns);
+            const uint64_t wakeup_ns = monotonic_ns();
+            m_wakeup_latency.record((wakeup_ns > deadline_ns) ? wakeup_ns - deadline_ns : 0);
+
+            const bool is_continued = cycle(deadline_ns);
+            const uint64_t end_ns = monotonic_ns();
+            m_cycle_duration.record(end_ns - wakeup_ns);
+            increment(m_cycle_count, 1);
+            if(!is_continued) break;
+
+            deadline_ns += m_period_ns;
+            if(end_ns >= deadline_ns)
+            {   //an overrun: the cycles that are due already are skipped, the next one runs on the grid
+                const uint64_t nmissed = (end_ns - deadline_ns) / m_period_ns + 1;
+                increment(m_overrun_count, 1);
+                increment(m_missed_count, nmissed);
+                deadline_ns += nmissed * m_period_ns;
+            }
+        }
+        m_is_running.store(false, std::memory_order_relaxed);
+    }
+
+    //the loop returns after the cycle that is running, if any
+    void stop()
+    {
+        m_is_running.store(false, std::memory_order_relaxed);
+    }
+
+    //from the deadline to the wake-up of the thread
+    const latency_histogram& get_wakeup_latency() const
+    {
+        return m_wakeup_latency;
+    }
+
+    //from the wake-up of the thread to the end of the cycle
+    const latency_histogram& get_cycle_duration() const
+    {
+        return m_cycle_duration;
+    }
+
+    uint64_t get_cycle_count() const
+    {
+        return m_cycle_count.load(std::memory_order_relaxed);
+    }
+
+    //cycles that ended after the next deadline
+    uint64_t get_overrun_count() const
+    {
+        return m_overrun_count.load(std::memory_order_relaxed);
+    }
+
+    //deadlines skipped because of overruns
+    uint64_t get_missed_count() const
+    {
+        return m_missed_count.load(std::memory_order_relaxed);
+    }
+
+    //the thread that runs the loop only
+    void reset_stats()
+    {
+        m_wakeup_latency.reset();
+        m_cycle_duration.reset();
+        m_cycle_count.store(0, std::memory_order_relaxed);
+        m_overrun_count.store(0, std::memory_order_relaxed);
+        m_missed_count.store(0, std::memory_order_relaxed);
+    }
+
+    //Prints out the counters and the percentiles of the wake-up latency and the cycle duration...
+    //...the histograms are reset, so that every dump covers the period since the previous one; the counters keep counting.
+    //...call it from the cycle, e.g. from a timer of the event loop that the cycle polls.
+    void dump(std::ostream& output)
+    {
+        output<<"Cycles: "<<get_cycle_count()<<" period: "<<m_period_ns<<" ns overruns: "<<get_overrun_count()
+              <<" missed: "<<get_missed_count()<<" memory locked: "<<m_is_memory_locked<<" pinned: "<<m_is_pinned
+              <<" SCHED_FIFO: "<<m_is_fifo<<'\n';
+        dump_histogram(output, "wake-up latency", m_wakeup_latency);
+        dump_histogram(output, "cycle", m_cycle_duration);
+        output<<std::flush;
+    }
+
+private:
+    uint64_t              m_period_ns;
+    std::atomic<bool>     m_is_running;
+    bool                  m_is_memory_locked;
+    bool                  m_is_pinned;
+    bool                  m_is_fifo;
+    latency_histogram     m_wakeup_latency;
+    latency_histogram     m_cycle_duration;
+    std::atomic<uint64_t> m_cycle_count;
+    std::atomic<uint64_t> m_overrun_count;
+    std::atomic<uint64_t> m_missed_count;
+
+    static void increment(std::atomic<uint64_t>& counter, uint64_t value)
+    {
+        counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+    }
+
+    static void sleep_until(uint64_t deadline_ns)
+    {
+        struct timespec deadline;
+        deadline.tv_sec  = static_cast<time_t>(deadline_ns / 1000000000ull);
+        deadline.tv_nsec = static_cast<long>  (deadline_ns % 1000000000ull);
+        while(::clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, nullptr) == EINTR) {}
+    }
+
+    //touches a page at a time of 'size' bytes below the current stack frame; not inlined, so that the frame is released
+    __attribute__((noinline)) static void prefault_stack(size_t size)
+    {
+        const size_t page_size = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+        volatile unsigned char* stack = static_cast<volatile unsigned char*>(alloca(size));
+        for(size_t i=0; i<size; i+=page_size) stack[i] = 0;
+    }
+
+    static void dump_histogram(std::ostream& output, const char* name, latency_histogram& h)
+    {
+        if(h.get_count() == 0) return;
+        output<<"  "<<name<<": count "<<h.get_count()<<" mean "<<h.get_mean_ns()<<" p50 "<<h.get_percentile_ns(0.5)
+              <<" p99 "<<h.get_percentile_ns(0.99)<<" p99.9 "<<h.get_percentile_ns(0.999)<<" max "<<h.get_max_ns()<<" ns"<<'\n';
+        h.reset();
+    }
+
+    realtime_loop(const realtime_loop&);            //non-copyable
+    realtime_loop& operator=(const realtime_loop&);
+};
+
+//Runs an event loop in real-time mode: instead of sleeping in epoll, the readers and the timers that are due
+//...are dispatched once per cycle; returns once event_loop::stop() is called from one of the handlers.
+inline void run_event_loop(realtime_loop& loop, event_loop& events)
+{
+    loop.run([&events](uint64_t)
+    {
+        return events.run_pending();
+    });
+}
+
+} //namespace servosila
+
+#endif // SERVOSILA_REALTIME_LOOP_H
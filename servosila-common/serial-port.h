@@ -0,0 +1,225 @@
+/////////////////////////////////////////////////////////////////////////////
+//
+//  This source code comes with Servosila SC-25C Brushless Motor Controllers.
+//  A serial port in raw mode for SLCAN adapters: whole buffers are read and
+//  written with single system calls, with no line discipline in between.
+//      OS: Linux
+//
+//  The code is provided "AS IS" without any kind of guarantees or warranties.
+//  Use it at your own risk.
+//
+//  The code is free for everyone to use, modify or redistribute.
+//
+//  www.servosila.com
+//
+/////////////////////////////////////////////////////////////////////////////
+
+#ifndef SERVOSILA_SERIAL_PORT_H
+#define SERVOSILA_SERIAL_PORT_H
+
+#include <stddef.h>             //size_t
+#include <stdint.h>             //standard integer types
+#include <string.h>             //memset()
+#include <stdlib.h>             //posix_openpt(), grantpt(), unlockpt(), ptsname_r()
+#include <fcntl.h>              //open()
+#include <unistd.h>             //read(), write(), close()
+#include <termios.h>            //tcgetattr(), tcsetattr(), cfmakeraw()
+#include <sys/ioctl.h>          //ioctl(), TIOCEXCL
+#include <linux/serial.h>       //struct serial_struct, ASYNC_LOW_LATENCY
+
+namespace servosila
+{
+
+//A serial port set up for the lowest and the most predictable latency:
+//...- raw mode: no echo, no line editing, no CR/LF translation, no XON/XOFF; SLCAN's '\r' reaches the decoder as it is;
+//...- non-blocking (VMIN=0, VTIME=0): read() returns whatever has arrived, at once, and the main loop waits with epoll;
+//...  in blocking mode (VMIN=1, VTIME=0) for a dedicated reader thread, read() returns as soon as the first symbol arrives;
+//...- ASYNC_LOW_LATENCY: the driver hands received symbols over right away instead of on its next tick (if supported;
+//...  USB CDC ACM adapters, e.g. /dev/ttyACM0, do not have the setting and pass data on as USB packets arrive anyway);
+//...- exclusive access (TIOCEXCL), so that a second program cannot interleave its symbols with ours.
+//The original settings of the port are restored by close().
+//The other end of the line can be played by a program, e.g. a simulator: open_pseudo_terminal() creates a pseudo-terminal
+//...whose other side, get_peer_name(), the application opens as if it were the adapter.
+class serial_port
+{
+public:
+    serial_port() : m_device(-1), m_peer(-1), m_is_low_latency(false), m_is_saved(false)
+    {
+        m_peer_name[0] = '\0';
+    }
+    ~serial_port() { close(); }
+
+    //Opens a serial device, e.g. "/dev/ttyACM0"...
+    //...'baud_rate' matters for UART-based adapters only (0 keeps the current one); USB CDC ACM adapters ignore it.
+    bool open(const char* device_name, uint32_t baud_rate = 0, bool is_blocking = false)
+    {
+        close();
+        m_device = ::open(device_name, O_RDWR | O_NOCTTY | O_CLOEXEC | (is_blocking ? 0 : O_NONBLOCK));
+        if(m_device < 0) return false;      //if this fails on Linux: sudo usermod -G dialout $USER
+
+        struct termios settings;
+        if(::tcgetattr(m_device, &settings) < 0)
+        {
+            close();
+            return false;
+        }
+        m_saved_settings = settings;
+        m_is_saved = true;
+
+        ::cfmakeraw(&settings);
+        settings.c_cflag |= CLOCAL | CREAD;     //no modem control lines; the receiver is on
+        settings.c_cflag &= ~CRTSCTS;
+        settings.c_cc[VMIN]  = is_blocking ? 1 : 0;
+        settings.c_cc[VTIME] = 0;
+        if(baud_rate != 0)
+        {
+            const speed_t speed = to_speed(baud_rate);
+            if(speed == B0 || ::cfsetispeed(&settings, speed) < 0 || ::cfsetospeed(&settings, speed) < 0)
+            {
+                close();
+                return false;
+            }
+        }
+        if(::tcsetattr(m_device, TCSANOW, &settings) < 0)
+        {
+            close();
+            return false;
+        }
+
+        //the symbols queued before the port was opened belong to no frame the application knows about
+        ::tcflush(m_device, TCIOFLUSH);
+        ::ioctl(m_device, TIOCEXCL);
+
+        struct serial_struct serial;
+        memset(&serial, 0, sizeof(serial));
+        if(::ioctl(m_device, TIOCGSERIAL, &serial) == 0)
+        {
+            serial.flags |= ASYNC_LOW_LATENCY;
+            m_is_low_latency = (::ioctl(m_device, TIOCSSERIAL, &serial) == 0);
+        }
+        return true;
+    }
+
+    //Creates a pseudo-terminal in raw mode and opens its master side, always non-blocking...
+    //...the application opens get_peer_name(), e.g. "/dev/pts/3". The master keeps its own handle of the other side,
+    //...so that the line does not hang up while no application has it open; the symbols written meanwhile are flushed by open().
+    bool open_pseudo_terminal()
+    {
+        close();
+        m_device = ::posix_openpt(O_RDWR | O_NOCTTY | O_CLOEXEC);
+        if(m_device < 0) return false;
+        if(::grantpt(m_device) < 0 || ::unlockpt(m_device) < 0 || ::ptsname_r(m_device, m_peer_name, sizeof(m_peer_name)) != 0)
+        {
+            close();
+            return false;
+        }
+        ::fcntl(m_device, F_SETFL, ::fcntl(m_device, F_GETFL) | O_NONBLOCK);
+
+        m_peer = ::open(m_peer_name, O_RDWR | O_NOCTTY | O_CLOEXEC | O_NONBLOCK);
+        struct termios settings;
+        if(m_peer < 0 || ::tcgetattr(m_peer, &settings) < 0)
+        {
+            close();
+            return false;
+        }
+        ::cfmakeraw(&settings);
+        settings.c_cflag |= CLOCAL | CREAD;
+        settings.c_cc[VMIN]  = 0;
+        settings.c_cc[VTIME] = 0;
+        if(::tcsetattr(m_peer, TCSANOW, &settings) < 0)
+        {
+            close();
+            return false;
+        }
+        return true;
+    }
+
+    void close()
+    {
+        if(m_device >= 0)
+        {
+            if(m_is_saved) ::tcsetattr(m_device, TCSANOW, &m_saved_settings);
+            ::ioctl(m_device, TIOCNXCL);
+            ::close(m_device);
+            m_device = -1;
+        }
+        if(m_peer >= 0)
+        {
+            ::close(m_peer);
+            m_peer = -1;
+        }
+        m_peer_name[0] = '\0';
+        m_is_low_latency = false;
+        m_is_saved = false;
+    }
+
+    bool is_open() const
+    {
+        return m_device >= 0;
+    }
+
+    //the descriptor to be waited on with poll()/epoll(); -1 if not open
+    int get_descriptor() const
+    {
+        return m_device;
+    }
+
+    //the device the application opens if this is the master side of a pseudo-terminal; empty otherwise
+    const char* get_peer_name() const
+    {
+        return m_peer_name;
+    }
+
+    //true if the driver has accepted ASYNC_LOW_LATENCY
+    bool is_low_latency() const
+    {
+        return m_is_low_latency;
+    }
+
+    //reads up to 'size' symbols that have arrived; returns -1 with errno EAGAIN if there are none (non-blocking mode)
+    ssize_t read(void* buffer, size_t size)
+    {
+        return ::read(m_device, buffer, size);
+    }
+
+    //writes up to 'size' symbols into the output buffer of the port; may write less if the buffer is full (non-blocking mode)
+    ssize_t write(const void* buffer, size_t size)
+    {
+        return ::write(m_device, buffer, size);
+    }
+
+private:
+    int            m_device;
+    int            m_peer;              //the other side of a pseudo-terminal, kept open by the master
+    char           m_peer_name[64];
+    bool           m_is_low_latency;
+    bool           m_is_saved;
+    struct termios m_saved_settings;
+
+    static speed_t to_speed(uint32_t baud_rate)
+    {
+        switch(baud_rate)
+        {
+            case 9600:    return B9600;
+            case 19200:   return B19200;
+            case 38400:   return B38400;
+            case 57600:   return B57600;
+            case 115200:  return B115200;
+            case 230400:  return B230400;
+            case 460800:  return B460800;
+            case 500000:  return B500000;
+            case 921600:  return B921600;
+            case 1000000: return B1000000;
+            case 2000000: return B2000000;
+            case 3000000: return B3000000;
+            default:      return B0;    //not a standard rate
+        }
+    }
+
+    serial_port(const serial_port&);            //non-copyable
+    serial_port& operator=(const serial_port&);
+};
+
+} //namespace servosila
+
+#endif // SERVOSILA_SERIAL_PORT_H
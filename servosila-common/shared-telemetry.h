@@ -0,0 +1,441 @@
+/////////////////////////////////////////////////////////////////////////////
+//
+//  This source code comes with Servosila SC-25C Brushless Motor Controllers.
+//  Telemetry published through POSIX shared memory, so that several local
+//  processes share one CAN interface: a daemon owns the interface and
+//  decodes the telemetry once, any number of readers map it.
+//      OS: Linux
+//
+//  The code is provided "AS IS" without any kind of guarantees or warranties.
+//  Use it at your own risk.
+//
+//  The code is free for everyone to use, modify or redistribute.
+//
+//  www.servosila.com
+//
+/////////////////////////////////////////////////////////////////////////////
+
+#ifndef SERVOSILA_SHARED_TELEMETRY_H
+#define SERVOSILA_SHARED_TELEMETRY_H
+
+#include "can-message.h"
+#include "telemetry-store.h"    //latest telemetry of every controller
+#include "frame-logger.h"       //frame_log_record
+#include "monotonic-clock.h"    //monotonic_ns()
+#include <stddef.h>             //size_t
+#include <stdint.h>             //standard integer types
+#include <string.h>             //memcpy(), memset()
+#include <errno.h>              //errno, EEXIST, EPERM
+#include <signal.h>             //kill()
+#include <new>                  //placement new
+#include <atomic>               //lock-free indices and sequence counters, C++11
+#include <fcntl.h>              //O_* constants
+#include <unistd.h>             //ftruncate(), close(), getpid()
+#include <sys/mman.h>           //shm_open(), mmap()
+#include <sys/stat.h>           //fstat()
+
+namespace servosila
+{
+
+static const char     SHARED_TELEMETRY_NAME[]   = "/servosila-telemetry";  //the default name of the shared memory object
+static const char     SHARED_TELEMETRY_MAGIC[8] = { 'S', 'V', 'T', 'E', 'L', 'S', 'H', 'M' };
+static const uint32_t SHARED_TELEMETRY_VERSION  = 3;
+static const uint64_t SHARED_TELEMETRY_TIMEOUT_NS = 1000000000ull;  //1s without a heartbeat and the daemon is taken for dead
+
+//The shared memory object holds:
+//...- the latest telemetry of every controller, as a telemetry_store (see telemetry-store.h);
+//...- a ring buffer of the latest 65536 received frames, so that a reader sees every frame, not just the latest state;
+//...- a queue of commands per reader that submits commands, a lane, from which the daemon sends them to the CAN network.
+//All of it is lock-free: the daemon never waits for a reader, and a slow or crashed reader does not affect the others...
+//...a lane has a single writer, so a command is either published whole or not at all, and the lane of a reader
+//...that has crashed is taken over by the next reader that needs one.
+//The atomics are shared between processes, which works because they are lock-free on every supported CPU.
+namespace shared_detail
+{
+    static const uint64_t FRAME_CAPACITY   = 65536;     //a power of two
+    static const uint64_t COMMAND_CAPACITY = 64;        //commands per lane, a power of two
+    static const size_t   COMMAND_LANE_COUNT = 16;      //readers that may submit commands at the same time
+    static const size_t   FRAME_WORD_COUNT = sizeof(frame_log_record) / sizeof(uint32_t);
+
+    //a frame slot is a seqlock: 'sequence' is 2*index+1 while frame number 'index' is being written, and 2*index+2 once it is complete
+    struct frame_slot
+    {
+        std::atomic<uint64_t> sequence;
+        std::atomic<uint32_t> words[FRAME_WORD_COUNT];   //a frame_log_record, copied word by word
+    };
+
+    //a single-producer queue of commands from the reader that owns the lane to the daemon
+    struct command_lane
+    {
+        std::atomic<uint32_t>             owner_pid;    //0 while the lane is free
+        alignas(64) std::atomic<uint64_t> tail;         //the number of commands submitted; written by the owner
+        alignas(64) std::atomic<uint64_t> head;         //the number of commands taken; written by the daemon
+        can_message                       messages[COMMAND_CAPACITY];
+    };
+
+    //EPERM: the process exists but belongs to another user
+    inline bool is_process_alive(uint32_t pid)
+    {
+        return pid > 0 && (::kill(static_cast<pid_t>(pid), 0) == 0 || errno == EPERM);
+    }
+
+    struct segment
+    {
+        char                  magic[8];         //SHARED_TELEMETRY_MAGIC
+        uint32_t              version;          //SHARED_TELEMETRY_VERSION
+        uint32_t              segment_size;     //sizeof(segment); guards against readers built with different capacities
+        std::atomic<uint32_t> is_online;        //1 from the end of the daemon's open() to its close()
+        std::atomic<uint32_t> publisher_pid;    //to tell a running daemon from a crashed one before the object is replaced
+        std::atomic<uint64_t> heartbeat_ns;     //monotonic_ns() time of the daemon's latest heartbeat()
+
+        alignas(64) std::atomic<uint64_t> frame_count;      //number of frames published so far
+
+        telemetry_store telemetry;
+        frame_slot      frames[FRAME_CAPACITY];
+        command_lane    lanes[COMMAND_LANE_COUNT];
+    };
+} //namespace shared_detail
+
+//The daemon side: creates the shared memory object and publishes every received frame.
+//ATTENTION: there must be only one publisher, and publish() must be called from one thread only.
+class shared_telemetry_publisher
+{
+public:
+    shared_telemetry_publisher() : m_segment(nullptr), m_frame_count(0), m_next_lane(0)
+    {
+        m_name[0] = '\0';
+    }
+
+    ~shared_telemetry_publisher()
+    {
+        close();
+    }
+
+    //creates the shared memory object; returns false if another daemon is running and owns it...
+    //...a stale object left by a daemon that has crashed is replaced; the readers still attached to it
+    //...see is_online() turn false once the heartbeats stop, and must attach again.
+    bool open(const char* name = SHARED_TELEMETRY_NAME)
+    {
+        close();
+        if(strlen(name) >= sizeof(m_name)) return false;
+
+        int fd = ::shm_open(name, O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0660);
+        if(fd < 0 && errno == EEXIST && !is_owner_alive(name))
+        {
+            ::shm_unlink(name);
+            fd = ::shm_open(name, O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0660);
+        }
+        if(fd < 0) return false;
+
+        const size_t size = sizeof(shared_detail::segment);
+        void* memory = MAP_FAILED;
+        if(::ftruncate(fd, static_cast<off_t>(size)) == 0)
+        {
+            memory = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        }
+        ::close(fd);    //the mapping stays valid
+        if(memory == MAP_FAILED)
+        {
+            ::shm_unlink(name);
+            return false;
+        }
+        strcpy(m_name, name);
+
+        //ftruncate() has zeroed the memory; the objects are constructed in place, so that the atomics are properly initialized
+        m_segment = new(memory) shared_detail::segment();
+        memcpy(m_segment->magic, SHARED_TELEMETRY_MAGIC, sizeof(m_segment->magic));
+        m_segment->version      = SHARED_TELEMETRY_VERSION;
+        m_segment->segment_size = static_cast<uint32_t>(size);
+        m_segment->publisher_pid.store(static_cast<uint32_t>(::getpid()), std::memory_order_relaxed);
+        m_segment->heartbeat_ns.store(monotonic_ns(), std::memory_order_relaxed);
+        m_segment->frame_count.store(0, std::memory_order_relaxed);
+        for(uint64_t i=0; i<shared_detail::FRAME_CAPACITY; i++) m_segment->frames[i].sequence.store(0, std::memory_order_relaxed);
+        for(size_t i=0; i<shared_detail::COMMAND_LANE_COUNT; i++)
+        {
+            m_segment->lanes[i].owner_pid.store(0, std::memory_order_relaxed);
+            m_segment->lanes[i].tail.store(0, std::memory_order_relaxed);
+            m_segment->lanes[i].head.store(0, std::memory_order_relaxed);
+        }
+        m_frame_count = 0;
+        m_next_lane = 0;
+
+        m_segment->is_online.store(1, std::memory_order_release);  //readers may attach from now on
+        return true;
+    }
+
+    //marks the telemetry offline and removes the shared memory object; attached readers keep their mappings until they detach
+    void close()
+    {
+        if(m_segment == nullptr) return;
+        m_segment->is_online.store(0, std::memory_order_release);
+        m_segment->~segment();
+        ::munmap(m_segment, sizeof(shared_detail::segment));
+        ::shm_unlink(m_name);
+        m_segment = nullptr;
+    }
+
+    bool is_open() const
+    {
+        return m_segment != nullptr;
+    }
+
+    //tells the readers that the daemon is alive; call it periodically, well within SHARED_TELEMETRY_TIMEOUT_NS,
+    //...e.g. from a timer of the main loop, so that a daemon that has crashed or hung is seen as offline.
+    void heartbeat()
+    {
+        if(m_segment != nullptr) m_segment->heartbeat_ns.store(monotonic_ns(), std::memory_order_release);
+    }
+
+    //publishes a received frame to the frame ring and, if it is a telemetry message, to the telemetry table...
+    //...returns the COB ID of a telemetry message (see telemetry_store::update()); 0 for other messages.
+    uint32_t publish(const can_message& message, uint64_t timestamp_ns, rx_timestamp_source timestamp_source = TIMESTAMP_RECEIVE)
+    {
+        if(m_segment == nullptr) return 0;
+
+        frame_log_record record;
+        record.timestamp_ns = timestamp_ns;
+        record.can_id       = message.can_id;
+        record.length       = message.length;
+        record.timestamp_source = static_cast<uint8_t>(timestamp_source);
+        memset(record.reserved, 0, sizeof(record.reserved));
+        memcpy(record.payload, message.payload, sizeof(record.payload));
+        uint32_t words[shared_detail::FRAME_WORD_COUNT];
+        memcpy(words, &record, sizeof(words));
+
+        const uint64_t index = m_frame_count++;
+        shared_detail::frame_slot& slot = m_segment->frames[index & (shared_detail::FRAME_CAPACITY - 1)];
+        slot.sequence.store(2*index + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        for(size_t i=0; i<shared_detail::FRAME_WORD_COUNT; i++) slot.words[i].store(words[i], std::memory_order_relaxed);
+        slot.sequence.store(2*index + 2, std::memory_order_release);
+        m_segment->frame_count.store(m_frame_count, std::memory_order_release);
+
+        return m_segment->telemetry.update(message, timestamp_ns);
+    }
+
+    //takes a command submitted by a reader; returns false if there is none...
+    //...the commands of a reader are taken in the order of submission, the lanes of the readers in turn.
+    bool try_pop_command(can_message& message)
+    {
+        if(m_segment == nullptr) return false;
+
+        for(size_t i=0; i<shared_detail::COMMAND_LANE_COUNT; i++)
+        {
+            shared_detail::command_lane& lane = m_segment->lanes[m_next_lane];
+            m_next_lane = (m_next_lane + 1) % shared_detail::COMMAND_LANE_COUNT;
+
+            const uint64_t head = lane.head.load(std::memory_order_relaxed);
+            if(lane.tail.load(std::memory_order_acquire) == head) continue;
+
+            message = lane.messages[head & (shared_detail::COMMAND_CAPACITY - 1)];
+            lane.head.store(head + 1, std::memory_order_release);   //the cell may be reused by the reader
+            return true;
+        }
+        return false;
+    }
+
+    //the telemetry table as the readers see it, e.g. for the daemon's own fault handling
+    const telemetry_store& get_telemetry() const
+    {
+        return m_segment->telemetry;
+    }
+
+private:
+    shared_detail::segment* m_segment;
+    uint64_t                m_frame_count;
+    size_t                  m_next_lane;    //the lane try_pop_command() looks at first
+    char                    m_name[256];
+
+    //true if the process recorded in an existing object is still running; a stale object, or one of another layout, can go
+    static bool is_owner_alive(const char* name)
+    {
+        const int fd = ::shm_open(name, O_RDONLY | O_CLOEXEC, 0);
+        if(fd < 0) return false;
+
+        struct stat file_stat;
+        const size_t size = sizeof(shared_detail::segment);
+        void* memory = MAP_FAILED;
+        if(::fstat(fd, &file_stat) == 0 && static_cast<size_t>(file_stat.st_size) == size)
+        {
+            memory = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+        }
+        ::close(fd);
+        if(memory == MAP_FAILED) return false;
+
+        const shared_detail::segment* segment = static_cast<const shared_detail::segment*>(memory);
+        const uint32_t pid = segment->publisher_pid.load(std::memory_order_acquire);
+        ::munmap(memory, size);
+        return shared_detail::is_process_alive(pid);
+    }
+
+    shared_telemetry_publisher(const shared_telemetry_publisher&);            //non-copyable
+    shared_telemetry_publisher& operator=(const shared_telemetry_publisher&);
+};
+
+//The reader side: maps the shared memory object created by the daemon.
+//...The telemetry table and the frames are read in place; nothing is sent through pipes or sockets.
+//ATTENTION: a subscriber object is used by one thread; every thread or process that reads frames needs its own subscriber.
+class shared_telemetry_subscriber
+{
+public:
+    shared_telemetry_subscriber() : m_segment(nullptr), m_p_lane(nullptr), m_cursor(0), m_lost_count(0) {}
+
+    ~shared_telemetry_subscriber()
+    {
+        close();
+    }
+
+    //returns false if the daemon is not running or has been built with a different layout
+    bool open(const char* name = SHARED_TELEMETRY_NAME)
+    {
+        close();
+
+        const int fd = ::shm_open(name, O_RDWR | O_CLOEXEC, 0);
+        if(fd < 0) return false;
+
+        struct stat file_stat;
+        const size_t size = sizeof(shared_detail::segment);
+        void* memory = MAP_FAILED;
+        if(::fstat(fd, &file_stat) == 0 && static_cast<size_t>(file_stat.st_size) == size)
+        {
+            memory = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        }
+        ::close(fd);
+        if(memory == MAP_FAILED) return false;
+
+        m_segment = static_cast<shared_detail::segment*>(memory);
+        if(!is_online()
+            || memcmp(m_segment->magic, SHARED_TELEMETRY_MAGIC, sizeof(m_segment->magic)) != 0
+            || m_segment->version != SHARED_TELEMETRY_VERSION
+            || m_segment->segment_size != size)
+        {
+            close();
+            return false;
+        }
+
+        //reading frames from now on; the frames received before open() are skipped
+        m_cursor = m_segment->frame_count.load(std::memory_order_acquire);
+        m_lost_count = 0;
+        return true;
+    }
+
+    void close()
+    {
+        if(m_segment == nullptr) return;
+        if(m_p_lane != nullptr)
+        {   //the commands still queued are sent out all the same
+            m_p_lane->owner_pid.store(0, std::memory_order_release);
+            m_p_lane = nullptr;
+        }
+        ::munmap(m_segment, sizeof(shared_detail::segment));
+        m_segment = nullptr;
+    }
+
+    bool is_open() const
+    {
+        return m_segment != nullptr;
+    }
+
+    //false once the daemon has stopped, or has sent no heartbeat for SHARED_TELEMETRY_TIMEOUT_NS, e.g. has crashed...
+    //...the telemetry is stale then, and open() has to be called again.
+    bool is_online() const
+    {
+        return m_segment != nullptr && m_segment->is_online.load(std::memory_order_acquire) == 1
+            && monotonic_ns() - m_segment->heartbeat_ns.load(std::memory_order_acquire) < SHARED_TELEMETRY_TIMEOUT_NS;
+    }
+
+    //the latest telemetry of every controller; use its read(), try_read() and get_sequence() (the reader side only)
+    const telemetry_store& get_telemetry() const
+    {
+        return m_segment->telemetry;
+    }
+
+    //copies up to 'count' frames received since the previous call, the oldest first; returns the number of frames copied...
+    //...a reader that falls more than 65536 frames behind loses the oldest frames; see get_lost_count().
+    size_t read_frames(frame_log_record* records, size_t count)
+    {
+        if(m_segment == nullptr) return 0;
+
+        const uint64_t frame_count = m_segment->frame_count.load(std::memory_order_acquire);
+        if(frame_count - m_cursor > shared_detail::FRAME_CAPACITY)
+        {   //the oldest unread frames have been overwritten already
+            m_lost_count += frame_count - m_cursor - shared_detail::FRAME_CAPACITY;
+            m_cursor = frame_count - shared_detail::FRAME_CAPACITY;
+        }
+
+        size_t nread = 0;
+        for(; m_cursor < frame_count && nread < count; m_cursor++)
+        {
+            const shared_detail::frame_slot& slot = m_segment->frames[m_cursor & (shared_detail::FRAME_CAPACITY - 1)];
+            const uint64_t expected = 2*m_cursor + 2;
+            if(slot.sequence.load(std::memory_order_acquire) != expected)
+            {   //overwritten by a newer frame in the meantime
+                m_lost_count++;
+                continue;
+            }
+
+            uint32_t words[shared_detail::FRAME_WORD_COUNT];
+            for(size_t i=0; i<shared_detail::FRAME_WORD_COUNT; i++) words[i] = slot.words[i].load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if(slot.sequence.load(std::memory_order_relaxed) != expected)
+            {
+                m_lost_count++;
+                continue;
+            }
+            memcpy(&(records[nread++]), words, sizeof(words));
+        }
+        return nread;
+    }
+
+    //number of frames this reader has missed because it fell behind
+    uint64_t get_lost_count() const
+    {
+        return m_lost_count;
+    }
+
+    //submits a command for the daemon to send; returns false if the daemon is offline, the lane of this reader is full,
+    //...or all COMMAND_LANE_COUNT lanes are owned by other readers. A lane is taken on the first call.
+    bool submit_command(const can_message& message)
+    {
+        if(!is_online()) return false;
+        if(m_p_lane == nullptr && !take_lane()) return false;
+
+        const uint64_t tail = m_p_lane->tail.load(std::memory_order_relaxed);
+        if(tail - m_p_lane->head.load(std::memory_order_acquire) >= shared_detail::COMMAND_CAPACITY) return false;
+
+        m_p_lane->messages[tail & (shared_detail::COMMAND_CAPACITY - 1)] = message;
+        m_p_lane->tail.store(tail + 1, std::memory_order_release);     //handing the command over to the daemon
+        return true;
+    }
+
+private:
+    shared_detail::segment*      m_segment;
+    shared_detail::command_lane* m_p_lane;      //the lane of this reader's commands; taken by submit_command()
+    uint64_t                     m_cursor;      //the number of the next frame to read
+    uint64_t                     m_lost_count;
+
+    //takes a free lane, or the lane of a reader that has died; the lane keeps the commands the owner has submitted
+    bool take_lane()
+    {
+        const uint32_t pid = static_cast<uint32_t>(::getpid());
+        for(size_t i=0; i<shared_detail::COMMAND_LANE_COUNT; i++)
+        {
+            shared_detail::command_lane& lane = m_segment->lanes[i];
+            uint32_t owner_pid = lane.owner_pid.load(std::memory_order_acquire);
+            if(owner_pid != 0 && shared_detail::is_process_alive(owner_pid)) continue;
+            if(lane.owner_pid.compare_exchange_strong(owner_pid, pid, std::memory_order_acq_rel))
+            {
+                m_p_lane = &lane;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    shared_telemetry_subscriber(const shared_telemetry_subscriber&);            //non-copyable
+    shared_telemetry_subscriber& operator=(const shared_telemetry_subscriber&);
+};
+
+} //namespace servosila
+
+#endif // SERVOSILA_SHARED_TELEMETRY_H
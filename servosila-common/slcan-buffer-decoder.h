@@ -0,0 +1,213 @@
+/////////////////////////////////////////////////////////////////////////////
+//
+//  This source code comes with Servosila SC-25C Brushless Motor Controllers.
+//  A decoder that turns whole chunks of SLCAN text into CAN messages.
+//
+//  The code is provided "AS IS" without any kind of guarantees or warranties.
+//  Use it at your own risk.
+//
+//  The code is free for everyone to use, modify or redistribute.
+//
+//  www.servosila.com
+//
+/////////////////////////////////////////////////////////////////////////////
+
+#ifndef SERVOSILA_SLCAN_BUFFER_DECODER_H
+#define SERVOSILA_SLCAN_BUFFER_DECODER_H
+
+#include "can-message.h"
+#include "can-id-filter.h"
+#include "hex-codec.h"
+#include <stddef.h>     //size_t
+#include <stdint.h>     //standard integer types
+#include <string.h>     //memchr(), memcpy(), memset()
+
+namespace servosila
+{
+
+//This decoder consumes SLCAN text in chunks of any size, e.g. a whole read() from a serial port,
+//...instead of one symbol per call. Every complete SLCAN frame found in a chunk is handed over to a callback.
+//...A frame that is split between two chunks is kept inside the decoder and completed on the next call.
+//Supported SLCAN frames: "tIIILDD..\r" (11-bit CAN ID) and "TIIIIIIIILDD..\r" (29-bit CAN ID).
+//...Other SLCAN replies (acknowledgements, error bells, remote frames) are skipped.
+class slcan_buffer_decoder
+{
+public:
+    slcan_buffer_decoder()
+    {
+        reset();
+    }
+
+    //Decodes a chunk of SLCAN text.
+    //...handler is any callable that accepts (const servosila::can_message&); it is called once per complete frame.
+    //...returns the number of frames handed over to the handler.
+    template<typename Handler>
+    size_t process_buffer(const char* buffer, size_t size, Handler&& handler)
+    {
+        size_t nframes = 0;
+        const char* position = buffer;
+        const char* const end = buffer + size;
+
+        //Step 1: completing a frame that started in the previous chunk
+        if(m_line_size > 0 || m_is_line_overflow)
+        {
+            const char* terminator = static_cast<const char*>(memchr(position, '\r', end - position));
+            const char* const line_end = (terminator != nullptr) ? terminator : end;
+            append_to_line(position, line_end - position);
+
+            if(terminator == nullptr) return 0;     //the frame is still incomplete, waiting for more symbols
+
+            if(!m_is_line_overflow)
+            {
+                nframes += decode_line(m_line, m_line_size, handler);
+            }
+            m_line_size = 0;
+            m_is_line_overflow = false;
+            position = terminator + 1;
+        }
+
+        //Step 2: decoding frames that are entirely inside this chunk, directly from the caller's buffer
+        while(position < end)
+        {
+            const char* terminator = static_cast<const char*>(memchr(position, '\r', end - position));
+            if(terminator == nullptr)
+            {   //the tail of the chunk is a partial frame; keeping it for the next call
+                append_to_line(position, end - position);
+                break;
+            }
+            nframes += decode_line(position, terminator - position, handler);
+            position = terminator + 1;
+        }
+
+        return nframes;
+    }
+
+    //Frames whose CAN ID is rejected by the filter are dropped right after the CAN ID is decoded,
+    //...before their payload is parsed. An empty filter (the default) lets all frames through.
+    void set_filter(const can_id_filter& filter)
+    {
+        m_filter = filter;
+    }
+
+    //Drops a partially received frame, if any. Use this after reopening the serial port.
+    void reset()
+    {
+        m_line_size = 0;
+        m_is_line_overflow = false;
+        m_error_count = 0;
+    }
+
+    //Returns how many malformed SLCAN frames have been dropped so far.
+    size_t get_error_count() const
+    {
+        return m_error_count;
+    }
+
+private:
+    //the longest SLCAN frame: 'T' + 8 symbols of CAN ID + DLC + 16 symbols of payload + 4 symbols of an optional timestamp
+    static const size_t MAX_LINE_SIZE = 1 + 8 + 1 + 16 + 4;
+
+    char   m_line[MAX_LINE_SIZE];   //a partial frame carried over between chunks (without the '\r' terminator)
+    size_t m_line_size;
+    bool   m_is_line_overflow;      //raised when garbage longer than any valid frame is being received
+    size_t m_error_count;
+    can_id_filter m_filter;
+
+    void append_to_line(const char* symbols, size_t count)
+    {
+        if(m_is_line_overflow) return;
+        if(m_line_size + count > MAX_LINE_SIZE)
+        {
+            m_is_line_overflow = true;
+            m_error_count++;
+            return;
+        }
+        memcpy(&(m_line[m_line_size]), symbols, count);
+        m_line_size += count;
+    }
+
+    //decodes one SLCAN line (without the '\r' terminator) and calls the handler if the line is a data frame
+    template<typename Handler>
+    size_t decode_line(const char* line, size_t size, Handler& handler)
+    {
+        //skipping anything in front of the frame type symbol, e.g. an error bell or a stray '\n'...
+        //...'t' and 'T' never appear among the hexadecimal symbols of a frame.
+        while(size > 0 && *line != 't' && *line != 'T')
+        {
+            if(*line == 'r' || *line == 'R') return 0;  //a remote frame, no payload to decode
+            line++;
+            size--;
+        }
+        if(size == 0) return 0;  //an acknowledgement or an empty line
+
+        can_message message;
+        const frame_status status = decode_frame(line, size, message);
+        if(status == FRAME_MALFORMED)
+        {
+            m_error_count++;
+            return 0;
+        }
+        if(status == FRAME_REJECTED) return 0;
+
+        handler(static_cast<const can_message&>(message));
+        return 1;
+    }
+
+    static int decode_hex_symbol(char symbol)
+    {
+        if(symbol >= '0' && symbol <= '9') return symbol - '0';
+        if(symbol >= 'A' && symbol <= 'F') return symbol - 'A' + 10;
+        if(symbol >= 'a' && symbol <= 'f') return symbol - 'a' + 10;
+        return -1;
+    }
+
+    static bool decode_hex(const char* symbols, size_t count, uint32_t& value)
+    {
+        value = 0;
+        for(size_t i=0; i<count; i++)
+        {
+            const int digit = decode_hex_symbol(symbols[i]);
+            if(digit < 0) return false;
+            value = (value << 4) | static_cast<uint32_t>(digit);
+        }
+        return true;
+    }
+
+    enum frame_status
+    {
+        FRAME_DECODED,
+        FRAME_REJECTED,     //a valid frame that did not pass the CAN ID filter
+        FRAME_MALFORMED
+    };
+
+    frame_status decode_frame(const char* line, size_t size, can_message& message) const
+    {
+        const size_t id_size = (line[0] == 't') ? 3 : 8;   //11-bit or 29-bit CAN ID
+        if(size < 1 + id_size + 1) return FRAME_MALFORMED;
+
+        uint32_t can_id = 0;
+        if(!decode_hex(&(line[1]), id_size, can_id)) return FRAME_MALFORMED;
+
+        const int length = decode_hex_symbol(line[1 + id_size]);
+        if(length < 0 || length > 8) return FRAME_MALFORMED;
+
+        //the frame may be followed by a 4-symbol timestamp if the adapter has timestamps enabled
+        const size_t payload_offset = 1 + id_size + 1;
+        const size_t frame_size = payload_offset + 2*length;
+        if(size != frame_size && size != frame_size + 4) return FRAME_MALFORMED;
+
+        //early reject: the payload of an unwanted frame is never parsed
+        if(!m_filter.accepts(can_id)) return FRAME_REJECTED;
+
+        message.can_id = can_id;
+        message.length = static_cast<uint8_t>(length);
+        memset(message.payload, 0, sizeof(message.payload));
+        //all payload symbols are decoded and validated at once, see hex-codec.h
+        if(!servosila::decode_hex(&(line[payload_offset]), static_cast<size_t>(length), message.payload)) return FRAME_MALFORMED;
+        return FRAME_DECODED;
+    }
+};
+
+} //namespace servosila
+
+#endif // SERVOSILA_SLCAN_BUFFER_DECODER_H
@@ -0,0 +1,211 @@
+/////////////////////////////////////////////////////////////////////////////
+//
+//  This source code comes with Servosila SC-25C Brushless Motor Controllers.
+//  Preformatted SLCAN text of the command messages, patched in place.
+//
+//  The code is provided "AS IS" without any kind of guarantees or warranties.
+//  Use it at your own risk.
+//
+//  The code is free for everyone to use, modify or redistribute.
+//
+//  www.servosila.com
+//
+/////////////////////////////////////////////////////////////////////////////
+
+#ifndef SERVOSILA_SLCAN_COMMAND_BUILDER_H
+#define SERVOSILA_SLCAN_COMMAND_BUILDER_H
+
+#include "can-message.h"
+#include "commands.h"               //command codes, make_command()
+#include "hex-codec.h"              //encode_hex8()
+#include "slcan-message-encoder.h"  //slcan_encode_message()
+#include <stddef.h>                 //size_t
+#include <stdint.h>                 //standard integer types
+#include <string.h>                 //memcpy()
+
+namespace servosila
+{
+
+//The SLCAN text of every ESC, STOP and RESET command of every Node ID is encoded once, in the constructor.
+//...Sending a command afterwards only re-encodes the payload symbols, and only if the payload differs from
+//...the previous command of the same kind to the same controller; the rest of the text is kept and nothing is allocated.
+//Commands to several controllers can be appended to a batch, so that they go out with a single write to the serial port.
+//ATTENTION: the builder is not thread-safe; the returned text stays valid until the next command of the same kind to the same controller.
+class slcan_command_builder
+{
+public:
+    static const uint32_t MAX_NODE_ID = 127;
+    static const size_t   MAX_BATCH_SIZE = 64;  //commands per batch
+
+    slcan_command_builder() : m_batch_size(0), m_batch_count(0)
+    {
+        const uint8_t KIND_CODES[KIND_COUNT] = { COMMAND_CODE_ESC, COMMAND_CODE_STOP, COMMAND_CODE_RESET };
+        for(uint32_t node_id=0; node_id<=MAX_NODE_ID; node_id++)
+        {
+            for(size_t kind=0; kind<KIND_COUNT; kind++)
+            {
+                command_template& t = m_templates[node_id][kind];
+                t.message = make_command(node_id, KIND_CODES[kind]);
+                t.size = slcan_encode_message(t.message, t.text);
+            }
+        }
+    }
+
+    //Returns the SLCAN text of a command; 'size' receives the number of chars.
+    //...ESC, STOP and RESET commands with 11-bit CAN IDs are patched from their templates; other messages are encoded in full.
+    const char* encode(const can_message& message, size_t& size)
+    {
+        command_template* t = find_template(message);
+        if(t == nullptr)
+        {   //not a command the builder has templates for
+            size = slcan_encode_message(message, m_scratch);
+            return m_scratch;
+        }
+
+        //an unchanged command (the usual case of a periodic refresh) costs one comparison;
+        //...a changed payload is re-encoded in place with a single vector operation, the rest of the text is kept.
+        uint64_t payload, previous;
+        memcpy(&payload,  message.payload,    sizeof(payload));
+        memcpy(&previous, t->message.payload, sizeof(previous));
+        if(payload != previous)
+        {
+            memcpy(t->message.payload, message.payload, sizeof(message.payload));
+            encode_hex8(message.payload, &(t->text[PAYLOAD_OFFSET]));
+        }
+        size = t->size;
+        return t->text;
+    }
+
+    //Returns the SLCAN text of an Electronic Speed Control command.
+    const char* encode_esc(uint32_t node_id, float speed, size_t& size)
+    {
+        return encode(make_esc_command(node_id & 0x7F, speed), size);
+    }
+
+    //Returns the SLCAN text of a STOP command.
+    const char* encode_stop(uint32_t node_id, size_t& size)
+    {
+        return encode(make_stop_command(node_id & 0x7F), size);
+    }
+
+    //Returns the SLCAN text of a RESET command.
+    const char* encode_reset(uint32_t node_id, size_t& size)
+    {
+        return encode(make_reset_command(node_id & 0x7F), size);
+    }
+
+    //Returns the latest ESC command to a controller as a CAN message, e.g. for socketcan::send_many().
+    const can_message& get_esc_message(uint32_t node_id, float speed)
+    {
+        size_t size = 0;
+        encode_esc(node_id, speed, size);
+        return m_templates[node_id & 0x7F][KIND_ESC].message;
+    }
+
+    //Batch: appends the SLCAN text of a command to the batch; returns false if the batch is full.
+    bool append(const can_message& message)
+    {
+        if(m_batch_count >= MAX_BATCH_SIZE) return false;
+        size_t size = 0;
+        const char* text = encode(message, size);
+        return append_text(text, size);
+    }
+
+    bool append_esc(uint32_t node_id, float speed)
+    {
+        if(m_batch_count >= MAX_BATCH_SIZE) return false;
+        size_t size = 0;
+        const char* text = encode_esc(node_id, speed, size);
+        return append_text(text, size);
+    }
+
+    bool append_stop(uint32_t node_id)
+    {
+        if(m_batch_count >= MAX_BATCH_SIZE) return false;
+        size_t size = 0;
+        const char* text = encode_stop(node_id, size);
+        return append_text(text, size);
+    }
+
+    bool append_reset(uint32_t node_id)
+    {
+        if(m_batch_count >= MAX_BATCH_SIZE) return false;
+        size_t size = 0;
+        const char* text = encode_reset(node_id, size);
+        return append_text(text, size);
+    }
+
+    //the SLCAN text of all commands appended since the last clear_batch(), to be written with a single write
+    const char* get_batch() const
+    {
+        return m_batch;
+    }
+
+    size_t get_batch_size() const
+    {
+        return m_batch_size;
+    }
+
+    size_t get_batch_count() const
+    {
+        return m_batch_count;
+    }
+
+    void clear_batch()
+    {
+        m_batch_size  = 0;
+        m_batch_count = 0;
+    }
+
+private:
+    enum command_kind
+    {
+        KIND_ESC,
+        KIND_STOP,
+        KIND_RESET,
+        KIND_COUNT
+    };
+    //"tIIIL" precedes the payload symbols of an 11-bit SLCAN frame
+    static const size_t PAYLOAD_OFFSET = 5;
+
+    struct command_template
+    {
+        can_message message;                    //the payload of the text below
+        char        text[SLCAN_MAX_FRAME_SIZE];
+        size_t      size;
+    };
+
+    command_template m_templates[MAX_NODE_ID + 1][KIND_COUNT];
+    char   m_scratch[SLCAN_MAX_FRAME_SIZE];
+    char   m_batch[MAX_BATCH_SIZE * SLCAN_MAX_FRAME_SIZE];
+    size_t m_batch_size;
+    size_t m_batch_count;
+
+    command_template* find_template(const can_message& message)
+    {
+        if(message.can_id > 0x7FF || message.length != 8 || (message.can_id & 0x780) != COMMAND_COB_ID) return nullptr;
+        const uint32_t node_id = message.can_id & 0x7F;
+        switch(message.payload[0])
+        {
+            case COMMAND_CODE_ESC:   return &(m_templates[node_id][KIND_ESC]);
+            case COMMAND_CODE_STOP:  return &(m_templates[node_id][KIND_STOP]);
+            case COMMAND_CODE_RESET: return &(m_templates[node_id][KIND_RESET]);
+        }
+        return nullptr;
+    }
+
+    bool append_text(const char* text, size_t size)
+    {
+        memcpy(&(m_batch[m_batch_size]), text, size);
+        m_batch_size += size;
+        m_batch_count++;
+        return true;
+    }
+
+    slcan_command_builder(const slcan_command_builder&);            //non-copyable
+    slcan_command_builder& operator=(const slcan_command_builder&);
+};
+
+} //namespace servosila
+
+#endif // SERVOSILA_SLCAN_COMMAND_BUILDER_H
@@ -0,0 +1,62 @@
+/////////////////////////////////////////////////////////////////////////////
+//
+//  This source code comes with Servosila SC-25C Brushless Motor Controllers.
+//  An encoder of CAN messages into SLCAN text frames.
+//
+//  The code is provided "AS IS" without any kind of guarantees or warranties.
+//  Use it at your own risk.
+//
+//  The code is free for everyone to use, modify or redistribute.
+//
+//  www.servosila.com
+//
+/////////////////////////////////////////////////////////////////////////////
+
+#ifndef SERVOSILA_SLCAN_MESSAGE_ENCODER_H
+#define SERVOSILA_SLCAN_MESSAGE_ENCODER_H
+
+#include "can-message.h"
+#include "hex-codec.h"  //encode_hex()
+#include <stddef.h>     //size_t
+#include <stdint.h>     //standard integer types
+
+namespace servosila
+{
+
+//the longest SLCAN frame: 'T' + 8 symbols of CAN ID + DLC + 16 symbols of payload + '\r'
+static const size_t SLCAN_MAX_FRAME_SIZE = 27;
+
+//Encodes a CAN message into an SLCAN text frame: "tIIILDD..\r" for 11-bit CAN IDs, "TIIIIIIIILDD..\r" for 29-bit CAN IDs.
+//...the output is the same as that of slcan_encode_11bit() for 11-bit CAN IDs; the payload is encoded with vector instructions.
+//...'buffer' must hold SLCAN_MAX_FRAME_SIZE chars; returns the number of chars written.
+inline size_t slcan_encode_message(const can_message& message, char* buffer)
+{
+    const uint8_t length = (message.length <= 8) ? message.length : 8;
+    size_t position = 0;
+
+    if(message.can_id <= 0x7FF)
+    {
+        buffer[position++] = 't';
+        buffer[position++] = hex_detail::HEX_SYMBOLS[(message.can_id >> 8) & 0x0F];
+        buffer[position++] = hex_detail::HEX_SYMBOLS[(message.can_id >> 4) & 0x0F];
+        buffer[position++] = hex_detail::HEX_SYMBOLS[ message.can_id       & 0x0F];
+    }
+    else
+    {
+        buffer[position++] = 'T';
+        for(int shift=28; shift>=0; shift-=4)
+        {
+            buffer[position++] = hex_detail::HEX_SYMBOLS[(message.can_id >> shift) & 0x0F];
+        }
+    }
+
+    buffer[position++] = hex_detail::HEX_SYMBOLS[length];
+    encode_hex(message.payload, length, &(buffer[position]));
+    position += 2*length;
+    buffer[position++] = '\r';
+    return position;
+}
+
+} //namespace servosila
+
+#endif // SERVOSILA_SLCAN_MESSAGE_ENCODER_H
@@ -0,0 +1,292 @@
+/////////////////////////////////////////////////////////////////////////////
+//
+//  This source code comes with Servosila SC-25C Brushless Motor Controllers.
+//  SLCAN over a virtual serial port, with the same interface as
+//  servosila::socketcan, so that the samples work with either transport.
+//      OS: Linux
+//
+//  The code is provided "AS IS" without any kind of guarantees or warranties.
+//  Use it at your own risk.
+//
+//  The code is free for everyone to use, modify or redistribute.
+//
+//  www.servosila.com
+//
+/////////////////////////////////////////////////////////////////////////////
+
+#ifndef SERVOSILA_SLCAN_TRANSPORT_H
+#define SERVOSILA_SLCAN_TRANSPORT_H
+
+#include "can-message.h"
+#include "can-id-filter.h"
+#include "slcan-buffer-decoder.h"   //SLCAN text to CAN messages
+#include "slcan-command-builder.h"  //CAN messages to SLCAN text
+#include "serial-port.h"            //raw mode serial port
+#include "instrumentation.h"        //receive_path_probe
+#include "monotonic-clock.h"        //monotonic_ns()
+#include <stddef.h>                 //size_t
+#include <stdint.h>                 //standard integer types
+#include <string.h>                 //memcpy(), memmove()
+#include <errno.h>                  //errno
+#include <poll.h>                   //poll()
+
+namespace servosila
+{
+
+//A USB-CAN adapter that speaks SLCAN, e.g. on /dev/ttyACM0.
+//...receive_many() reads a whole block of SLCAN text with one system call and decodes it at once;
+//...the frames that do not fit into the caller's array are kept for the next call.
+//...send_many() encodes the frames from preformatted templates and writes them with one system call.
+//...Like servosila::socketcan, the device never blocks; the main loop waits for get_socket() with epoll.
+//...The port is in raw mode with low-latency settings (see serial-port.h).
+class slcan_transport
+{
+public:
+    slcan_transport() : m_pending_begin(0), m_pending_end(0), m_pending_timestamp_ns(0), m_is_hung_up(false), m_unsent_size(0), m_p_probe(nullptr) {}
+    ~slcan_transport() { shutdown(); }
+
+    //opens a serial device, e.g. "/dev/ttyACM0"; 'baud_rate' matters for UART-based adapters only
+    bool startup(const char* device_name, uint32_t baud_rate = 0)
+    {
+        shutdown();
+        return m_port.open(device_name, baud_rate);
+    }
+
+    //plays the adapter rather than talking to one, e.g. in a simulator: the application opens get_port().get_peer_name()
+    bool startup_pseudo_terminal()
+    {
+        shutdown();
+        return m_port.open_pseudo_terminal();
+    }
+
+    void shutdown()
+    {
+        m_port.close();
+        m_decoder.reset();
+        m_pending_begin = 0;
+        m_pending_end   = 0;
+        m_is_hung_up    = false;
+        m_unsent_size   = 0;
+    }
+
+    //false once a read or a write of the port has failed with an error other than "try again", e.g. EIO...
+    //...the port stays open until shutdown(). An unplugged adapter is reported by epoll (see event_loop::add_reader()).
+    bool is_connected() const
+    {
+        return m_port.is_open() && !m_is_hung_up;
+    }
+
+    //the serial port descriptor to be waited on; -1 if not connected
+    int get_socket() const
+    {
+        return m_port.get_descriptor();
+    }
+
+    //the serial port, e.g. to check is_low_latency() or to get_peer_name() of a pseudo-terminal
+    serial_port& get_port()
+    {
+        return m_port;
+    }
+
+    //frames rejected by the filter are dropped by the decoder right after their CAN ID is decoded
+    bool set_filter(const can_id_filter& filter)
+    {
+        m_decoder.set_filter(filter);
+        return true;
+    }
+
+    //the time the decoding takes, the symbols read and the malformed frames are reported to the probe, if any
+    void set_probe(receive_path_probe* p_probe)
+    {
+        m_p_probe = p_probe;
+    }
+
+    //serial ports have no receive timestamps; the frames of a block are stamped with the return of read()
+    bool set_timestamping(rx_timestamp_source source)
+    {
+        return source == TIMESTAMP_RECEIVE;
+    }
+
+    rx_timestamp_source get_timestamp_source() const
+    {
+        return TIMESTAMP_RECEIVE;
+    }
+
+    //receives up to 'count' CAN frames; returns the number of frames written to 'messages', 0 if there is nothing to read...
+    //...if the returned value equals 'count', more frames may still be waiting.
+    size_t receive_many(can_message* messages, size_t count)
+    {
+        return receive_many(messages, nullptr, count);
+    }
+
+    //same as above; the time of arrival of every frame is written to 'timestamps_ns'
+    size_t receive_many(can_message* messages, uint64_t* timestamps_ns, size_t count)
+    {
+        size_t nreceived = 0;
+        while(nreceived < count)
+        {
+            if(m_pending_begin == m_pending_end && !read_pending()) break;
+
+            while(nreceived < count && m_pending_begin < m_pending_end)
+            {
+                if(timestamps_ns != nullptr) timestamps_ns[nreceived] = m_pending_timestamp_ns;
+                messages[nreceived++] = m_pending[m_pending_begin++];
+            }
+        }
+        return nreceived;
+    }
+
+    //sends up to 'count' CAN frames, up to 64 frames per system call...
+    //...returns the number of frames written; a value below 'count' means the serial port's output buffer is full.
+    size_t send_many(const can_message* messages, size_t count)
+    {
+        return send_many(messages, count, WRITE_TIMEOUT_MS);
+    }
+
+    //same as above, but never waits for room in the output buffer, e.g. for a simulator that has to keep its pace
+    //...while nobody reads the other side of its pseudo-terminal.
+    size_t try_send_many(const can_message* messages, size_t count)
+    {
+        return send_many(messages, count, 0);
+    }
+
+    //serial ports do not report lost frames; see get_error_count() for the frames lost to line noise
+    uint32_t get_dropped_count() const
+    {
+        return 0;
+    }
+
+    //how many malformed SLCAN frames have been dropped so far
+    size_t get_error_count() const
+    {
+        return m_decoder.get_error_count();
+    }
+
+private:
+    //symbols read per system call, and the most frames they can hold ("t0000\r" is the shortest frame)
+    static const size_t READ_BUFFER_SIZE = 4096;
+    static const size_t PENDING_CAPACITY = READ_BUFFER_SIZE / 6 + 1;
+
+    //how long a write waits for the output buffer of the serial port to drain before it gives up
+    static const int WRITE_TIMEOUT_MS = 10;
+
+    serial_port           m_port;
+    slcan_buffer_decoder  m_decoder;
+    slcan_command_builder m_builder;
+    char                  m_buffer[READ_BUFFER_SIZE];
+    can_message           m_pending[PENDING_CAPACITY];    //decoded frames not handed over yet
+    size_t                m_pending_begin;
+    size_t                m_pending_end;
+    uint64_t              m_pending_timestamp_ns;     //the return of the read() the pending frames came from
+    bool                  m_is_hung_up;
+    char                  m_unsent[SLCAN_MAX_FRAME_SIZE]; //the rest of a frame cut short by a full output buffer
+    size_t                m_unsent_size;
+    receive_path_probe*   m_p_probe;
+
+    //reads a block of symbols and decodes it; returns false if there is nothing to read
+    bool read_pending()
+    {
+        m_pending_begin = 0;
+        m_pending_end   = 0;
+        while(m_pending_end == 0)
+        {
+            const ssize_t nread = m_port.read(m_buffer, sizeof(m_buffer));
+            if(nread < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+            {   //e.g. EIO: the other side of a pseudo-terminal has been closed
+                m_is_hung_up = true;
+                return false;
+            }
+            if(nread <= 0) return false;    //no symbols left to be read out; a raw mode port returns 0 rather than EAGAIN
+
+            m_pending_timestamp_ns = monotonic_ns();
+            const uint64_t parse_start_ns = m_pending_timestamp_ns;
+            m_decoder.process_buffer(m_buffer, static_cast<size_t>(nread), [this](const can_message& message)
+            {
+                if(m_pending_end < PENDING_CAPACITY) m_pending[m_pending_end++] = message;
+            });
+            if(IS_INSTRUMENTATION_ENABLED && m_p_probe != nullptr)
+            {
+                m_p_probe->record(STAGE_PARSE, parse_start_ns, probe_ns());
+                m_p_probe->add(COUNTER_BYTES, static_cast<uint64_t>(nread));
+                m_p_probe->set(COUNTER_DECODE_ERRORS, m_decoder.get_error_count());
+            }
+        }
+        return true;
+    }
+
+    size_t send_many(const can_message* messages, size_t count, int timeout_ms)
+    {
+        //the rest of a frame cut short by the previous call goes first, so that the adapter never sees half a frame
+        if(m_unsent_size > 0)
+        {
+            const size_t nwritten = write_all(m_unsent, m_unsent_size, timeout_ms);
+            m_unsent_size -= nwritten;
+            memmove(m_unsent, &(m_unsent[nwritten]), m_unsent_size);
+            if(m_unsent_size > 0) return 0;
+        }
+
+        size_t nsent = 0;
+        while(nsent < count)
+        {
+            //the end of the text of every frame in the batch, so that a partial write is reported in whole frames
+            size_t frame_ends[slcan_command_builder::MAX_BATCH_SIZE];
+            size_t nframes = 0;
+            m_builder.clear_batch();
+            while(nsent + nframes < count && m_builder.append(messages[nsent + nframes]))
+            {
+                frame_ends[nframes++] = m_builder.get_batch_size();
+            }
+            if(nframes == 0) break;
+
+            const size_t nwritten = write_all(m_builder.get_batch(), m_builder.get_batch_size(), timeout_ms);
+            size_t ncomplete = 0;
+            while(ncomplete < nframes && frame_ends[ncomplete] <= nwritten) ncomplete++;
+            const size_t frame_begin = (ncomplete > 0) ? frame_ends[ncomplete - 1] : 0;
+            if(ncomplete < nframes && nwritten > frame_begin)
+            {   //a frame has been cut short: its rest is kept for the next call, and the frame counts as sent
+                m_unsent_size = frame_ends[ncomplete] - nwritten;
+                memcpy(m_unsent, &(m_builder.get_batch()[nwritten]), m_unsent_size);
+                ncomplete++;
+            }
+            nsent += ncomplete;
+            if(ncomplete < nframes || m_unsent_size > 0) break;
+        }
+        return nsent;
+    }
+
+    //writes a whole block, waiting up to 'timeout_ms' at a time for room in the output buffer; returns the number of bytes written
+    size_t write_all(const char* data, size_t size, int timeout_ms)
+    {
+        size_t nwritten = 0;
+        while(nwritten < size)
+        {
+            const ssize_t result = m_port.write(data + nwritten, size - nwritten);
+            if(result > 0)
+            {
+                nwritten += static_cast<size_t>(result);
+                continue;
+            }
+            if(result < 0 && errno == EINTR) continue;
+            if(result < 0 && errno != EAGAIN && errno != EWOULDBLOCK)
+            {   //e.g. the adapter has been unplugged
+                m_is_hung_up = true;
+                break;
+            }
+            if(timeout_ms == 0) break;
+
+            struct pollfd descriptor;
+            descriptor.fd      = m_port.get_descriptor();
+            descriptor.events  = POLLOUT;
+            descriptor.revents = 0;
+            if(::poll(&descriptor, 1, timeout_ms) <= 0) break;
+        }
+        return nwritten;
+    }
+
+    slcan_transport(const slcan_transport&);            //non-copyable
+    slcan_transport& operator=(const slcan_transport&);
+};
+
+} //namespace servosila
+
+#endif // SERVOSILA_SLCAN_TRANSPORT_H
@@ -0,0 +1,409 @@
+/////////////////////////////////////////////////////////////////////////////
+//
+//  This source code comes with Servosila SC-25C Brushless Motor Controllers.
+//  Linux SocketCAN encapsulation that exposes the socket descriptor
+//  so that the socket can be waited on with poll()/epoll().
+//      OS: Linux
+//
+//  The code is provided "AS IS" without any kind of guarantees or warranties.
+//  Use it at your own risk.
+//
+//  The code is free for everyone to use, modify or redistribute.
+//
+//  www.servosila.com
+//
+/////////////////////////////////////////////////////////////////////////////
+
+#ifndef SERVOSILA_SOCKETCAN_H
+#define SERVOSILA_SOCKETCAN_H
+
+#include "can-message.h"
+#include "can-id-filter.h"
+#include "monotonic-clock.h"    //monotonic_ns()
+#include <stdint.h>             //standard integer types
+#include <string.h>             //memcpy(), memset(), strncpy()
+#include <unistd.h>             //close(), read(), write()
+#include <fcntl.h>              //fcntl()
+#include <errno.h>              //errno
+#include <sys/socket.h>         //socket(), bind(), recvmmsg(), sendmmsg()
+#include <sys/ioctl.h>          //ioctl()
+#include <net/if.h>             //struct ifreq
+#include <linux/can.h>          //struct can_frame
+#include <linux/can/raw.h>      //CAN_RAW, CAN_RAW_FILTER
+#include <linux/net_tstamp.h>   //SOF_TIMESTAMPING_* flags
+#include <linux/errqueue.h>     //struct scm_timestamping
+#include <time.h>               //clock_gettime()
+#include <vector>               //a list of kernel filters
+
+namespace servosila
+{
+
+//A non-blocking raw SocketCAN socket.
+//...The interface mirrors servosila::canbus (startup/shutdown/send/receive),
+//...and in addition exposes the socket descriptor for event-driven main loops.
+class socketcan
+{
+public:
+    socketcan() : m_socket(-1), m_dropped_count(0), m_timestamp_source(TIMESTAMP_RECEIVE) {}
+    ~socketcan() { shutdown(); }
+
+    //opens a raw CAN socket bound to a network interface, e.g. "can0" or "vcan0"
+    bool startup(const char* network_name)
+    {
+        shutdown();
+
+        m_socket = ::socket(PF_CAN, SOCK_RAW, CAN_RAW);
+        if(m_socket < 0) return false;
+
+        struct ifreq ifr;
+        memset(&ifr, 0, sizeof(ifr));
+        strncpy(ifr.ifr_name, network_name, IFNAMSIZ - 1);
+        if(::ioctl(m_socket, SIOCGIFINDEX, &ifr) < 0)
+        {
+            shutdown();
+            return false;
+        }
+
+        struct sockaddr_can addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.can_family  = AF_CAN;
+        addr.can_ifindex = ifr.ifr_ifindex;
+        if(::bind(m_socket, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) < 0)
+        {
+            shutdown();
+            return false;
+        }
+
+        //the socket never blocks; the main loop waits for it with poll()/epoll() instead
+        const int flags = ::fcntl(m_socket, F_GETFL, 0);
+        ::fcntl(m_socket, F_SETFL, flags | O_NONBLOCK);
+
+        //asking the kernel to report how many frames it has dropped because the receive queue was full (see get_dropped_count())
+        const int enable = 1;
+        ::setsockopt(m_socket, SOL_SOCKET, SO_RXQ_OVFL, &enable, sizeof(enable));
+        m_dropped_count = 0;
+        m_timestamp_source = TIMESTAMP_RECEIVE;
+
+        return true;
+    }
+
+    void shutdown()
+    {
+        if(m_socket >= 0)
+        {
+            ::close(m_socket);
+            m_socket = -1;
+        }
+    }
+
+    bool is_connected() const
+    {
+        return m_socket >= 0;
+    }
+
+    //the socket descriptor to be waited on; -1 if not connected
+    int get_socket() const
+    {
+        return m_socket;
+    }
+
+    //how many frames the kernel has dropped since startup() because the socket's receive queue was full...
+    //...updated by receive_many(); a growing value means that the application does not read the socket fast enough.
+    uint32_t get_dropped_count() const
+    {
+        return m_dropped_count;
+    }
+
+    //Chooses where the times of arrival returned by receive_many() come from:
+    //...TIMESTAMP_RECEIVE  - the return of the system call; the frame may have waited in the socket for a while;
+    //...TIMESTAMP_KERNEL   - the kernel stamps every frame as the CAN driver hands it over, before it is queued;
+    //...TIMESTAMP_HARDWARE - the CAN controller stamps every frame as it comes off the wire; frames that the driver
+    //...                     has not stamped get the kernel time instead.
+    //...The kernel reports the times in CLOCK_REALTIME; they are converted to monotonic_ns() time base.
+    //...Returns false if the kernel does not support the source; the previous source stays in effect.
+    bool set_timestamping(rx_timestamp_source source)
+    {
+        int flags = 0;
+        if(source != TIMESTAMP_RECEIVE) flags |= SOF_TIMESTAMPING_RX_SOFTWARE | SOF_TIMESTAMPING_SOFTWARE;
+        if(source == TIMESTAMP_HARDWARE) flags |= SOF_TIMESTAMPING_RX_HARDWARE | SOF_TIMESTAMPING_RAW_HARDWARE;
+        if(::setsockopt(m_socket, SOL_SOCKET, SO_TIMESTAMPING, &flags, sizeof(flags)) < 0) return false;
+
+        m_timestamp_source = source;
+        return true;
+    }
+
+    rx_timestamp_source get_timestamp_source() const
+    {
+        return m_timestamp_source;
+    }
+
+    //installs a kernel-side filter, so that only the frames the application is interested in wake it up
+    //...the filter is a product of Node IDs and COB IDs; an empty filter lets all frames through.
+    //...the kernel accepts up to 512 filter entries; for larger products only the COB IDs (or only the Node IDs)
+    //...are filtered by the kernel, and the application should check can_id_filter::accepts() on the rest.
+    bool set_filter(const can_id_filter& filter)
+    {
+        std::vector<struct can_filter> filters;
+
+        //masks include the EFF and RTR flags, so that only 11-bit data frames match
+        const canid_t NODE_MASK = 0x07F | CAN_EFF_FLAG | CAN_RTR_FLAG;
+        const canid_t COB_MASK  = 0x780 | CAN_EFF_FLAG | CAN_RTR_FLAG;
+        const canid_t ID_MASK   = CAN_SFF_MASK | CAN_EFF_FLAG | CAN_RTR_FLAG;
+
+        std::vector<canid_t> node_ids;
+        std::vector<canid_t> cob_ids;
+        for(canid_t node_id=0; node_id<=0x7F; node_id++)
+        {
+            if(filter.is_node_filter_set() && filter.accepts_node_id(node_id)) node_ids.push_back(node_id);
+        }
+        for(canid_t cob_id=0; cob_id<=0x780; cob_id+=0x80)
+        {
+            if(filter.is_cob_filter_set() && filter.accepts_cob_id(cob_id)) cob_ids.push_back(cob_id);
+        }
+
+        if(filter.is_empty())
+        {
+            struct can_filter pass_all;
+            pass_all.can_id   = 0;
+            pass_all.can_mask = 0;
+            filters.push_back(pass_all);
+        }
+        else if(!node_ids.empty() && !cob_ids.empty() && node_ids.size() * cob_ids.size() <= CAN_RAW_FILTER_MAX)
+        {   //exact filter: every (COB ID + Node ID) pair
+            for(size_t i=0; i<cob_ids.size(); i++)
+            {
+                for(size_t j=0; j<node_ids.size(); j++)
+                {
+                    struct can_filter f;
+                    f.can_id   = cob_ids[i] + node_ids[j];
+                    f.can_mask = ID_MASK;
+                    filters.push_back(f);
+                }
+            }
+        }
+        else if(!cob_ids.empty() && (node_ids.empty() || cob_ids.size() <= node_ids.size()))
+        {   //filtering by COB ID only
+            for(size_t i=0; i<cob_ids.size(); i++)
+            {
+                struct can_filter f;
+                f.can_id   = cob_ids[i];
+                f.can_mask = COB_MASK;
+                filters.push_back(f);
+            }
+        }
+        else
+        {   //filtering by Node ID only
+            for(size_t j=0; j<node_ids.size(); j++)
+            {
+                struct can_filter f;
+                f.can_id   = node_ids[j];
+                f.can_mask = NODE_MASK;
+                filters.push_back(f);
+            }
+        }
+
+        return ::setsockopt(m_socket, SOL_CAN_RAW, CAN_RAW_FILTER, filters.data(), static_cast<socklen_t>(filters.size() * sizeof(struct can_filter))) == 0;
+    }
+
+    //sends a single CAN frame; returns false if the frame could not be queued
+    bool send(uint32_t can_id, const void* payload, uint8_t nbytes)
+    {
+        if(nbytes > 8) return false;
+
+        struct can_frame frame;
+        memset(&frame, 0, sizeof(frame));
+        frame.can_id  = (can_id > CAN_SFF_MASK) ? (can_id | CAN_EFF_FLAG) : can_id;
+        frame.can_dlc = nbytes;
+        memcpy(frame.data, payload, nbytes);
+
+        return ::write(m_socket, &frame, sizeof(frame)) == static_cast<ssize_t>(sizeof(frame));
+    }
+
+    //receives a single CAN frame if one is queued; returns false if there is nothing to read
+    bool receive(can_message& message)
+    {
+        struct can_frame frame;
+        const ssize_t nread = ::read(m_socket, &frame, sizeof(frame));
+        if(nread != static_cast<ssize_t>(sizeof(frame))) return false;
+
+        from_can_frame(frame, message);
+        return true;
+    }
+
+    //receives up to 'count' CAN frames with a single system call (recvmmsg)
+    //...returns the number of frames written to 'messages'; 0 if there is nothing to read.
+    //...if the returned value equals 'count', more frames may still be queued in the socket.
+    size_t receive_many(can_message* messages, size_t count)
+    {
+        return receive_many(messages, nullptr, count);
+    }
+
+    //same as above; the time of arrival of every frame is written to 'timestamps_ns' (see set_timestamping())
+    size_t receive_many(can_message* messages, uint64_t* timestamps_ns, size_t count)
+    {
+        struct can_frame frames[MAX_BATCH_SIZE];
+        struct iovec     iov[MAX_BATCH_SIZE];
+        struct mmsghdr   headers[MAX_BATCH_SIZE];
+        control_buffer   controls[MAX_BATCH_SIZE];
+
+        size_t nreceived = 0;
+        while(nreceived < count)
+        {
+            const size_t batch_size = (count - nreceived < MAX_BATCH_SIZE) ? (count - nreceived) : MAX_BATCH_SIZE;
+            prepare_headers(frames, iov, headers, batch_size);
+            for(size_t i=0; i<batch_size; i++)
+            {
+                headers[i].msg_hdr.msg_control    = controls[i].data;
+                headers[i].msg_hdr.msg_controllen = CONTROL_SIZE;
+            }
+
+            const int nframes = ::recvmmsg(m_socket, headers, static_cast<unsigned int>(batch_size), MSG_DONTWAIT, nullptr);
+            if(nframes <= 0) break;     //EAGAIN: the socket has been drained
+
+            //the clocks are read once per batch: the time of return, and the offset of CLOCK_REALTIME from CLOCK_MONOTONIC
+            uint64_t receive_ns = 0;
+            int64_t  realtime_offset_ns = 0;
+            if(timestamps_ns != nullptr)
+            {
+                receive_ns = monotonic_ns();
+                if(m_timestamp_source != TIMESTAMP_RECEIVE) realtime_offset_ns = static_cast<int64_t>(realtime_ns()) - static_cast<int64_t>(receive_ns);
+            }
+
+            for(int i=0; i<nframes; i++)
+            {
+                if(timestamps_ns != nullptr)
+                {
+                    timestamps_ns[nreceived] = (m_timestamp_source != TIMESTAMP_RECEIVE) ? read_timestamp(headers[i].msg_hdr, receive_ns, realtime_offset_ns) : receive_ns;
+                }
+                from_can_frame(frames[i], messages[nreceived++]);
+            }
+            //the drop counter is cumulative, so the one of the latest frame is enough
+            read_dropped_count(headers[nframes - 1].msg_hdr);
+            if(static_cast<size_t>(nframes) < batch_size) break;
+        }
+        return nreceived;
+    }
+
+    //sends up to 'count' CAN frames with a single system call (sendmmsg)
+    //...returns the number of frames queued; a value below 'count' means the socket's send queue is full.
+    size_t send_many(const can_message* messages, size_t count)
+    {
+        struct can_frame frames[MAX_BATCH_SIZE];
+        struct iovec     iov[MAX_BATCH_SIZE];
+        struct mmsghdr   headers[MAX_BATCH_SIZE];
+
+        size_t nsent = 0;
+        while(nsent < count)
+        {
+            const size_t batch_size = (count - nsent < MAX_BATCH_SIZE) ? (count - nsent) : MAX_BATCH_SIZE;
+            for(size_t i=0; i<batch_size; i++)
+            {
+                to_can_frame(messages[nsent + i], frames[i]);
+            }
+            prepare_headers(frames, iov, headers, batch_size);
+
+            const int nframes = ::sendmmsg(m_socket, headers, static_cast<unsigned int>(batch_size), MSG_DONTWAIT);
+            if(nframes <= 0) break;     //ENOBUFS/EAGAIN: the send queue is full
+
+            nsent += static_cast<size_t>(nframes);
+            if(static_cast<size_t>(nframes) < batch_size) break;
+        }
+        return nsent;
+    }
+
+    //the same as send_many(), which never waits; for the code shared with slcan_transport
+    size_t try_send_many(const can_message* messages, size_t count)
+    {
+        return send_many(messages, count);
+    }
+
+    //converts a SocketCAN frame into a can_message
+    static void from_can_frame(const struct can_frame& frame, can_message& message)
+    {
+        message.can_id = (frame.can_id & CAN_EFF_FLAG) ? (frame.can_id & CAN_EFF_MASK) : (frame.can_id & CAN_SFF_MASK);
+        message.length = (frame.can_dlc <= 8) ? frame.can_dlc : 8;
+        memset(message.payload, 0, sizeof(message.payload));
+        memcpy(message.payload, frame.data, message.length);
+    }
+
+    //converts a can_message into a SocketCAN frame
+    static void to_can_frame(const can_message& message, struct can_frame& frame)
+    {
+        memset(&frame, 0, sizeof(frame));
+        frame.can_id  = (message.can_id > CAN_SFF_MASK) ? (message.can_id | CAN_EFF_FLAG) : message.can_id;
+        frame.can_dlc = (message.length <= 8) ? message.length : 8;
+        memcpy(frame.data, message.payload, frame.can_dlc);
+    }
+
+private:
+    //frames moved per system call; larger requests are split into several calls
+    static const size_t MAX_BATCH_SIZE = 64;
+
+    //ancillary data per frame: the SO_RXQ_OVFL drop counter and the SO_TIMESTAMPING times
+    static const size_t CONTROL_SIZE = CMSG_SPACE(sizeof(uint32_t)) + CMSG_SPACE(sizeof(struct scm_timestamping));
+
+    //CMSG_FIRSTHDR() and CMSG_NXTHDR() read the ancillary data as struct cmsghdr, so the buffer must be aligned for it
+    union control_buffer
+    {
+        struct cmsghdr header;
+        char           data[CONTROL_SIZE];
+    };
+
+    int                 m_socket;
+    uint32_t            m_dropped_count;
+    rx_timestamp_source m_timestamp_source;
+
+    static uint64_t realtime_ns()
+    {
+        struct timespec ts;
+        ::clock_gettime(CLOCK_REALTIME, &ts);
+        return static_cast<uint64_t>(ts.tv_sec) * 1000000000ull + static_cast<uint64_t>(ts.tv_nsec);
+    }
+
+    //the time of arrival of a frame in monotonic_ns() time base; 'receive_ns' if the kernel has not stamped the frame
+    uint64_t read_timestamp(struct msghdr& header, uint64_t receive_ns, int64_t realtime_offset_ns) const
+    {
+        for(struct cmsghdr* c = CMSG_FIRSTHDR(&header); c != nullptr; c = CMSG_NXTHDR(&header, c))
+        {
+            if(c->cmsg_level != SOL_SOCKET || c->cmsg_type != SCM_TIMESTAMPING) continue;
+
+            struct scm_timestamping stamps;
+            memcpy(&stamps, CMSG_DATA(c), sizeof(stamps));
+            //ts[0] is the software time, ts[2] is the hardware time
+            const struct timespec& ts = (m_timestamp_source == TIMESTAMP_HARDWARE && (stamps.ts[2].tv_sec != 0 || stamps.ts[2].tv_nsec != 0)) ? stamps.ts[2] : stamps.ts[0];
+            if(ts.tv_sec == 0 && ts.tv_nsec == 0) break;
+
+            const int64_t arrival_ns = static_cast<int64_t>(ts.tv_sec) * 1000000000ll + ts.tv_nsec - realtime_offset_ns;
+            //the frame cannot have arrived after it was received; this only happens if the system time is being set
+            return (arrival_ns > 0 && static_cast<uint64_t>(arrival_ns) < receive_ns) ? static_cast<uint64_t>(arrival_ns) : receive_ns;
+        }
+        return receive_ns;
+    }
+
+    void read_dropped_count(struct msghdr& header)
+    {
+        for(struct cmsghdr* c = CMSG_FIRSTHDR(&header); c != nullptr; c = CMSG_NXTHDR(&header, c))
+        {
+            if(c->cmsg_level == SOL_SOCKET && c->cmsg_type == SO_RXQ_OVFL) memcpy(&m_dropped_count, CMSG_DATA(c), sizeof(m_dropped_count));
+        }
+    }
+
+    static void prepare_headers(struct can_frame* frames, struct iovec* iov, struct mmsghdr* headers, size_t count)
+    {
+        memset(headers, 0, count * sizeof(struct mmsghdr));
+        for(size_t i=0; i<count; i++)
+        {
+            iov[i].iov_base = &(frames[i]);
+            iov[i].iov_len  = sizeof(struct can_frame);
+            headers[i].msg_hdr.msg_iov    = &(iov[i]);
+            headers[i].msg_hdr.msg_iovlen = 1;
+        }
+    }
+
+    socketcan(const socketcan&);            //non-copyable
+    socketcan& operator=(const socketcan&);
+};
+
+} //namespace servosila
+
+#endif // SERVOSILA_SOCKETCAN_H
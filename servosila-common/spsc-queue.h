@@ -0,0 +1,97 @@
+/////////////////////////////////////////////////////////////////////////////
+//
+//  This source code comes with Servosila SC-25C Brushless Motor Controllers.
+//  A lock-free queue between exactly one producer thread and exactly one
+//  consumer thread.
+//
+//  The code is provided "AS IS" without any kind of guarantees or warranties.
+//  Use it at your own risk.
+//
+//  The code is free for everyone to use, modify or redistribute.
+//
+//  www.servosila.com
+//
+/////////////////////////////////////////////////////////////////////////////
+
+#ifndef SERVOSILA_SPSC_QUEUE_H
+#define SERVOSILA_SPSC_QUEUE_H
+
+#include <stddef.h>     //size_t
+#include <stdint.h>     //standard integer types
+#include <atomic>       //lock-free ring buffer indices, C++11
+#include <vector>       //preallocated ring buffer
+
+namespace servosila
+{
+
+//A preallocated ring buffer of items that are copied in and out; neither side ever blocks or allocates.
+//...The producer (e.g. the thread that decodes telemetry) calls try_push(); if the consumer (e.g. the GUI thread)
+//...falls behind and the queue fills up, try_push() returns false and the item is up to the producer to drop or keep.
+//ATTENTION: try_push() must be called from one thread only, and try_pop() from one other thread only.
+template<typename T>
+class spsc_queue
+{
+public:
+    //capacity is rounded up to a power of two
+    explicit spsc_queue(size_t capacity = 65536) : m_mask(0), m_head(0), m_tail(0)
+    {
+        size_t size = 1;
+        while(size < capacity) size <<= 1;
+        m_ring.resize(size);
+        m_mask = size - 1;
+    }
+
+    //Producer side: returns false if the queue is full
+    bool try_push(const T& item)
+    {
+        const uint64_t head = m_head.load(std::memory_order_relaxed);
+        if(head - m_tail.load(std::memory_order_acquire) > m_mask) return false;
+
+        m_ring[head & m_mask] = item;
+        m_head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    //Consumer side: returns false if the queue is empty
+    bool try_pop(T& item)
+    {
+        const uint64_t tail = m_tail.load(std::memory_order_relaxed);
+        if(tail == m_head.load(std::memory_order_acquire)) return false;
+
+        item = m_ring[tail & m_mask];
+        m_tail.store(tail + 1, std::memory_order_release);   //the slot may be reused by try_push() now
+        return true;
+    }
+
+    //Consumer side: pops up to 'count' items at once; returns the number of items popped
+    size_t pop_many(T* items, size_t count)
+    {
+        const uint64_t tail = m_tail.load(std::memory_order_relaxed);
+        const uint64_t available = m_head.load(std::memory_order_acquire) - tail;
+        const size_t npopped = (available < count) ? static_cast<size_t>(available) : count;
+
+        for(size_t i=0; i<npopped; i++) items[i] = m_ring[(tail + i) & m_mask];
+        m_tail.store(tail + npopped, std::memory_order_release);
+        return npopped;
+    }
+
+    size_t get_capacity() const
+    {
+        return m_ring.size();
+    }
+
+private:
+    std::vector<T> m_ring;
+    uint64_t       m_mask;
+
+    //the indices are on separate cache lines, so that the producer and the consumer do not slow each other down
+    alignas(64) std::atomic<uint64_t> m_head;   //written by the producer
+    alignas(64) std::atomic<uint64_t> m_tail;   //written by the consumer
+
+    spsc_queue(const spsc_queue&);              //non-copyable
+    spsc_queue& operator=(const spsc_queue&);
+};
+
+} //namespace servosila
+
+#endif // SERVOSILA_SPSC_QUEUE_H
@@ -0,0 +1,343 @@
+/////////////////////////////////////////////////////////////////////////////
+//
+//  This source code comes with Servosila SC-25C Brushless Motor Controllers.
+//  A table-driven decoder of the telemetry messages (PDOs 0x180..0x480).
+//
+//  The code is provided "AS IS" without any kind of guarantees or warranties.
+//  Use it at your own risk.
+//
+//  The code is free for everyone to use, modify or redistribute.
+//
+//  www.servosila.com
+//
+/////////////////////////////////////////////////////////////////////////////
+
+#ifndef SERVOSILA_TELEMETRY_DECODER_H
+#define SERVOSILA_TELEMETRY_DECODER_H
+
+#include "can-message.h"
+#include "canopen-decoder.h"    //decode_float16(), extract_cob_id_from_can_id()
+#include "float16-batch.h"     //decode_float16_batch()
+#include <stddef.h>             //size_t, offsetof()
+#include <stdint.h>             //standard integer types
+#include <string.h>             //memcpy()
+#include <type_traits>          //std::integral_constant, C++11
+
+namespace servosila
+{
+
+//How a value is transmitted in the payload of a telemetry message.
+//...Refer to Servosila Device Reference document for the formats of telemetry messages by their COB IDs.
+enum pdo_field_type
+{
+    PDO_UINT8,
+    PDO_INT8,
+    PDO_UINT16,
+    PDO_INT16,
+    PDO_UINT32,
+    PDO_INT32,
+    PDO_FLOAT16,    //ATTENTION: FLOAT16 is transmitted as INT16 and is converted with decode_float16()
+    PDO_FLOAT32
+};
+
+//One value in the payload of a telemetry message, and where it goes in the decoded structure.
+//...integer values with a scale of 1 are stored as they are; FLOAT16, FLOAT32 and scaled values are stored as float.
+struct pdo_field
+{
+    uint8_t        offset;  //position in the payload, bytes
+    pdo_field_type type;    //how the value is transmitted
+    float          scale;   //the decoded value is multiplied by this factor
+    size_t         target;  //position of the member in the decoded structure, offsetof()
+};
+
+//Decoded telemetry messages, one structure per COB ID.
+struct telemetry_180
+{
+    uint16_t fault_bits;    //non-zero if the controller reports a fault
+    float    Udc;           //DC voltage, V
+    float    speed;         //speed, Hz (electrical)
+};
+
+//The channels of 0x280, 0x380 and 0x480 telemetry messages depend on the device and its firmware...
+//...the layouts below expose the payload as four INT16 channels. Once the formats of your device are known
+//...from Servosila Device Reference document, change the structures and the field tables, not the decoding code.
+struct telemetry_280
+{
+    int16_t channel[4];
+};
+
+struct telemetry_380
+{
+    int16_t channel[4];
+};
+
+struct telemetry_480
+{
+    int16_t channel[4];
+};
+
+//Layouts of telemetry messages: each layout is declared once as a constant field table.
+//...decode_pdo() unrolls the table at compile time, so decoding is a sequence of loads and stores without branches.
+struct pdo_180_layout
+{
+    typedef telemetry_180 record;
+    static const uint32_t COB_ID = 0x180;
+    static constexpr pdo_field fields[] =
+    {
+        { 0, PDO_UINT16,  1.0f, offsetof(telemetry_180, fault_bits) },
+        { 2, PDO_FLOAT16, 1.0f, offsetof(telemetry_180, Udc)        },
+        { 4, PDO_FLOAT32, 1.0f, offsetof(telemetry_180, speed)      }
+    };
+};
+
+struct pdo_280_layout
+{
+    typedef telemetry_280 record;
+    static const uint32_t COB_ID = 0x280;
+    static constexpr pdo_field fields[] =
+    {
+        { 0, PDO_INT16, 1.0f, offsetof(telemetry_280, channel) + 0 },
+        { 2, PDO_INT16, 1.0f, offsetof(telemetry_280, channel) + 2 },
+        { 4, PDO_INT16, 1.0f, offsetof(telemetry_280, channel) + 4 },
+        { 6, PDO_INT16, 1.0f, offsetof(telemetry_280, channel) + 6 }
+    };
+};
+
+struct pdo_380_layout
+{
+    typedef telemetry_380 record;
+    static const uint32_t COB_ID = 0x380;
+    static constexpr pdo_field fields[] =
+    {
+        { 0, PDO_INT16, 1.0f, offsetof(telemetry_380, channel) + 0 },
+        { 2, PDO_INT16, 1.0f, offsetof(telemetry_380, channel) + 2 },
+        { 4, PDO_INT16, 1.0f, offsetof(telemetry_380, channel) + 4 },
+        { 6, PDO_INT16, 1.0f, offsetof(telemetry_380, channel) + 6 }
+    };
+};
+
+struct pdo_480_layout
+{
+    typedef telemetry_480 record;
+    static const uint32_t COB_ID = 0x480;
+    static constexpr pdo_field fields[] =
+    {
+        { 0, PDO_INT16, 1.0f, offsetof(telemetry_480, channel) + 0 },
+        { 2, PDO_INT16, 1.0f, offsetof(telemetry_480, channel) + 2 },
+        { 4, PDO_INT16, 1.0f, offsetof(telemetry_480, channel) + 4 },
+        { 6, PDO_INT16, 1.0f, offsetof(telemetry_480, channel) + 6 }
+    };
+};
+
+//The latest telemetry of one controller, all four telemetry messages.
+struct node_telemetry
+{
+    telemetry_180 pdo_180;
+    telemetry_280 pdo_280;
+    telemetry_380 pdo_380;
+    telemetry_480 pdo_480;
+};
+
+namespace pdo_detail
+{
+    //the type a value is transmitted as
+    template<pdo_field_type Type> struct wire_type;
+    template<> struct wire_type<PDO_UINT8>   { typedef uint8_t  type; };
+    template<> struct wire_type<PDO_INT8>    { typedef int8_t   type; };
+    template<> struct wire_type<PDO_UINT16>  { typedef uint16_t type; };
+    template<> struct wire_type<PDO_INT16>   { typedef int16_t  type; };
+    template<> struct wire_type<PDO_UINT32>  { typedef uint32_t type; };
+    template<> struct wire_type<PDO_INT32>   { typedef int32_t  type; };
+    template<> struct wire_type<PDO_FLOAT16> { typedef int16_t  type; };
+    template<> struct wire_type<PDO_FLOAT32> { typedef float    type; };
+
+    //the type a value is stored as in the decoded structure, and the conversion
+    template<pdo_field_type Type, bool IsScaled>
+    struct converter
+    {   //integers as they are
+        typedef typename wire_type<Type>::type value_type;
+        static value_type convert(typename wire_type<Type>::type raw, float) { return raw; }
+    };
+
+    template<pdo_field_type Type>
+    struct converter<Type, true>
+    {   //scaled integers and scaled FLOAT32
+        typedef float value_type;
+        static float convert(typename wire_type<Type>::type raw, float scale) { return static_cast<float>(raw) * scale; }
+    };
+
+    template<>
+    struct converter<PDO_FLOAT32, false>
+    {
+        typedef float value_type;
+        static float convert(float raw, float) { return raw; }
+    };
+
+    template<>
+    struct converter<PDO_FLOAT16, false>
+    {
+        typedef float value_type;
+        static float convert(int16_t raw, float) { return decode_float16(raw); }
+    };
+
+    template<>
+    struct converter<PDO_FLOAT16, true>
+    {
+        typedef float value_type;
+        static float convert(int16_t raw, float scale) { return decode_float16(raw) * scale; }
+    };
+
+    //the field table is read at compile time only, so the layouts need no out-of-class definitions
+    template<typename Layout, size_t I>
+    struct field_decoder
+    {
+        static constexpr uint8_t        OFFSET    = Layout::fields[I].offset;
+        static constexpr pdo_field_type TYPE      = Layout::fields[I].type;
+        static constexpr bool           IS_SCALED = (Layout::fields[I].scale != 1.0f);
+        static constexpr float          SCALE     = Layout::fields[I].scale;
+        static constexpr size_t         TARGET    = Layout::fields[I].target;
+
+        typedef typename wire_type<TYPE>::type raw_type;
+        typedef converter<TYPE, IS_SCALED> value_converter;
+        typedef typename value_converter::value_type value_type;
+
+        static_assert(OFFSET + sizeof(raw_type) <= 8, "a telemetry field does not fit in the CAN payload");
+        static_assert(TARGET + sizeof(value_type) <= sizeof(typename Layout::record), "a telemetry field does not fit in the decoded structure");
+
+        static void decode(const uint8_t* payload, typename Layout::record& record)
+        {
+            raw_type raw;
+            memcpy(&raw, payload + OFFSET, sizeof(raw));
+            const value_type value = value_converter::convert(raw, SCALE);
+            memcpy(reinterpret_cast<uint8_t*>(&record) + TARGET, &value, sizeof(value));
+        }
+
+        //decodes this field of many messages of the same layout; FLOAT16 values are converted in batches
+        static void decode_batch(const can_message* messages, size_t count, typename Layout::record* records)
+        {
+            decode_batch(messages, count, records, std::integral_constant<bool, TYPE == PDO_FLOAT16>());
+        }
+
+        static void decode_batch(const can_message* messages, size_t count, typename Layout::record* records, std::false_type)
+        {
+            for(size_t i=0; i<count; i++) decode(messages[i].payload, records[i]);
+        }
+
+        static void decode_batch(const can_message* messages, size_t count, typename Layout::record* records, std::true_type)
+        {
+            const size_t CHUNK_SIZE = 64;
+            int16_t raw[CHUNK_SIZE];
+            float   values[CHUNK_SIZE];
+            for(size_t base=0; base<count; base+=CHUNK_SIZE)
+            {
+                const size_t chunk_size = (count - base < CHUNK_SIZE) ? (count - base) : CHUNK_SIZE;
+                for(size_t i=0; i<chunk_size; i++) memcpy(&(raw[i]), messages[base + i].payload + OFFSET, sizeof(raw[i]));
+
+                decode_float16_batch(raw, values, chunk_size);
+
+                for(size_t i=0; i<chunk_size; i++)
+                {
+                    const float value = IS_SCALED ? values[i] * SCALE : values[i];
+                    memcpy(reinterpret_cast<uint8_t*>(&(records[base + i])) + TARGET, &value, sizeof(value));
+                }
+            }
+        }
+
+        //the number of payload bytes the fields up to and including this one need
+        static constexpr size_t required_length(size_t previous)
+        {
+            return (OFFSET + sizeof(raw_type) > previous) ? OFFSET + sizeof(raw_type) : previous;
+        }
+    };
+
+    template<typename Layout, size_t I, size_t N>
+    struct fields_decoder
+    {
+        static void decode(const uint8_t* payload, typename Layout::record& record)
+        {
+            field_decoder<Layout, I>::decode(payload, record);
+            fields_decoder<Layout, I + 1, N>::decode(payload, record);
+        }
+
+        static void decode_batch(const can_message* messages, size_t count, typename Layout::record* records)
+        {
+            field_decoder<Layout, I>::decode_batch(messages, count, records);
+            fields_decoder<Layout, I + 1, N>::decode_batch(messages, count, records);
+        }
+
+        static constexpr size_t required_length(size_t previous)
+        {
+            return fields_decoder<Layout, I + 1, N>::required_length(field_decoder<Layout, I>::required_length(previous));
+        }
+    };
+
+    template<typename Layout, size_t N>
+    struct fields_decoder<Layout, N, N>
+    {
+        static void decode(const uint8_t*, typename Layout::record&) {}
+        static void decode_batch(const can_message*, size_t, typename Layout::record*) {}
+        static constexpr size_t required_length(size_t previous) { return previous; }
+    };
+
+    template<typename Layout>
+    struct layout_traits
+    {
+        static constexpr size_t FIELD_COUNT = sizeof(Layout::fields) / sizeof(pdo_field);
+        static constexpr size_t REQUIRED_LENGTH = fields_decoder<Layout, 0, FIELD_COUNT>::required_length(0);
+    };
+} //namespace pdo_detail
+
+//The number of payload bytes a telemetry message of this layout must have.
+template<typename Layout>
+constexpr size_t pdo_required_length()
+{
+    return pdo_detail::layout_traits<Layout>::REQUIRED_LENGTH;
+}
+
+//Decodes the payload of a telemetry message into the structure of its layout.
+//...the caller makes sure that the payload is at least pdo_required_length<Layout>() bytes long.
+template<typename Layout>
+inline void decode_pdo(const uint8_t* payload, typename Layout::record& record)
+{
+    pdo_detail::fields_decoder<Layout, 0, pdo_detail::layout_traits<Layout>::FIELD_COUNT>::decode(payload, record);
+}
+
+//Decodes many telemetry messages of the same layout at once, e.g. all 0x180 messages of a recorded session.
+//...the fields are decoded one at a time across all messages, so that FLOAT16 values are converted in batches
+//...with decode_float16_batch(). The caller makes sure that every message has the layout's COB ID and length.
+template<typename Layout>
+inline void decode_pdo_batch(const can_message* messages, size_t count, typename Layout::record* records)
+{
+    pdo_detail::fields_decoder<Layout, 0, pdo_detail::layout_traits<Layout>::FIELD_COUNT>::decode_batch(messages, count, records);
+}
+
+//Decodes a telemetry message of any of the four telemetry COB IDs into the telemetry of its controller.
+//...returns the COB ID of the decoded message; 0 if the message is not a telemetry message or is too short.
+inline uint32_t decode_telemetry(const can_message& message, node_telemetry& telemetry)
+{
+    const uint32_t COB_ID = extract_cob_id_from_can_id(message.can_id);
+    switch(COB_ID)
+    {
+        case pdo_180_layout::COB_ID:
+            if(message.length < pdo_required_length<pdo_180_layout>()) return 0;
+            decode_pdo<pdo_180_layout>(message.payload, telemetry.pdo_180);
+            return COB_ID;
+        case pdo_280_layout::COB_ID:
+            if(message.length < pdo_required_length<pdo_280_layout>()) return 0;
+            decode_pdo<pdo_280_layout>(message.payload, telemetry.pdo_280);
+            return COB_ID;
+        case pdo_380_layout::COB_ID:
+            if(message.length < pdo_required_length<pdo_380_layout>()) return 0;
+            decode_pdo<pdo_380_layout>(message.payload, telemetry.pdo_380);
+            return COB_ID;
+        case pdo_480_layout::COB_ID:
+            if(message.length < pdo_required_length<pdo_480_layout>()) return 0;
+            decode_pdo<pdo_480_layout>(message.payload, telemetry.pdo_480);
+            return COB_ID;
+    }
+    return 0;
+}
+
+} //namespace servosila
+
+#endif // SERVOSILA_TELEMETRY_DECODER_H
@@ -0,0 +1,131 @@
+/////////////////////////////////////////////////////////////////////////////
+//
+//  This source code comes with Servosila SC-25C Brushless Motor Controllers.
+//  The receive path shared by all transports: receiving frames in batches,
+//  logging them and decoding the telemetry.
+//
+//  The code is provided "AS IS" without any kind of guarantees or warranties.
+//  Use it at your own risk.
+//
+//  The code is free for everyone to use, modify or redistribute.
+//
+//  www.servosila.com
+//
+/////////////////////////////////////////////////////////////////////////////
+
+#ifndef SERVOSILA_TELEMETRY_PIPELINE_H
+#define SERVOSILA_TELEMETRY_PIPELINE_H
+
+#include "can-message.h"
+#include "telemetry-store.h"    //telemetry decoding
+#include "frame-logger.h"       //binary recording of CAN traffic
+#include "instrumentation.h"    //receive_path_probe
+#include "monotonic-clock.h"    //monotonic_ns()
+#include <stddef.h>             //size_t
+#include <stdint.h>             //standard integer types
+
+namespace servosila
+{
+
+//The pipeline works with any transport that has these methods (the transport is a template parameter,
+//...so the calls are resolved at compile time and inlined; there is no virtual call per frame):
+//...    int      get_socket() const;                                        a descriptor for epoll
+//...    bool     set_filter(const can_id_filter& filter);
+//...    size_t   receive_many(can_message* messages, uint64_t* timestamps_ns, size_t count);
+//...                                                                         never blocks; times of arrival in monotonic_ns() base
+//...    rx_timestamp_source get_timestamp_source() const;                   where the times of arrival come from
+//...    size_t   send_many(const can_message* messages, size_t count);      never blocks for long
+//...    uint32_t get_dropped_count() const;                                 frames lost before they were received
+//The transports: servosila::socketcan (socketcan.h), servosila::slcan_transport (slcan-transport.h)
+//...and servosila::memory_transport (memory-transport.h).
+template<typename Transport>
+class telemetry_pipeline
+{
+public:
+    //the maximum number of frames received per call of receive_many()
+    static const size_t BATCH_SIZE = 64;
+
+    telemetry_pipeline(Transport& transport, telemetry_store& telemetry)
+        : m_transport(transport), m_telemetry(telemetry), m_p_logger(nullptr), m_p_probe(nullptr) {}
+
+    //every received frame is recorded into the log, if any
+    void set_logger(frame_logger* p_logger)
+    {
+        m_p_logger = p_logger;
+    }
+
+    //the stages of the receive path are timed into the probe, if any (see instrumentation.h)
+    void set_probe(receive_path_probe* p_probe)
+    {
+        m_p_probe = p_probe;
+    }
+
+    Transport& get_transport()
+    {
+        return m_transport;
+    }
+
+    //Drains the transport: call it when get_socket() becomes readable...
+    //...every frame is logged and decoded into the telemetry store, then handed over to 'handler', which is any callable
+    //...'void(const can_message& message, uint32_t cob_id, uint64_t timestamp_ns)'; 'cob_id' is 0 if the frame is not telemetry.
+    //...'timestamp_ns' is the time of arrival of the frame as reported by the transport (see socketcan::set_timestamping()).
+    //...returns the number of frames received.
+    template<typename Handler>
+    size_t process(Handler&& handler)
+    {
+        const bool is_probed = IS_INSTRUMENTATION_ENABLED && m_p_probe != nullptr;
+        const rx_timestamp_source timestamp_source = m_transport.get_timestamp_source();
+        can_message messages[BATCH_SIZE];
+        uint64_t    timestamps_ns[BATCH_SIZE];     //the times of arrival, shared by the log and the telemetry table
+        size_t nframes = 0;
+        while(true)
+        {
+            const uint64_t read_start_ns = probe_ns();
+            const size_t nmessages = m_transport.receive_many(messages, timestamps_ns, BATCH_SIZE);
+            if(is_probed)
+            {
+                m_p_probe->record(STAGE_READ, read_start_ns, probe_ns());
+                m_p_probe->add(COUNTER_READS, 1);
+                m_p_probe->add(COUNTER_FRAMES, nmessages);
+            }
+
+            for(size_t i=0; i<nmessages; i++)
+            {
+                const can_message& message = messages[i];
+                const uint64_t timestamp_ns = timestamps_ns[i];
+                const uint64_t decode_start_ns = probe_ns();
+                if(m_p_logger != nullptr) m_p_logger->log(message, timestamp_ns, timestamp_source);
+                const uint32_t cob_id = m_telemetry.update(message, timestamp_ns);
+                const uint64_t decoded_ns = probe_ns();
+
+                handler(message, cob_id, timestamp_ns);
+
+                if(is_probed)
+                {
+                    const uint64_t handled_ns = probe_ns();
+                    m_p_probe->record(STAGE_DECODE, decode_start_ns, decoded_ns);
+                    m_p_probe->record(STAGE_HANDLER, decoded_ns, handled_ns);
+                    //the later frames of a batch also wait for the earlier ones to be processed
+                    m_p_probe->record(STAGE_END_TO_END, timestamp_ns, handled_ns);
+                }
+            }
+            nframes += nmessages;
+            if(nmessages < BATCH_SIZE) break;   //the transport has been drained
+        }
+        if(is_probed) m_p_probe->set(COUNTER_DROPPED_FRAMES, m_transport.get_dropped_count());
+        return nframes;
+    }
+
+private:
+    Transport&          m_transport;
+    telemetry_store&    m_telemetry;
+    frame_logger*       m_p_logger;
+    receive_path_probe* m_p_probe;
+
+    telemetry_pipeline(const telemetry_pipeline&);              //non-copyable
+    telemetry_pipeline& operator=(const telemetry_pipeline&);
+};
+
+} //namespace servosila
+
+#endif // SERVOSILA_TELEMETRY_PIPELINE_H
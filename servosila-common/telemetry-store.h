@@ -0,0 +1,181 @@
+/////////////////////////////////////////////////////////////////////////////
+//
+//  This source code comes with Servosila SC-25C Brushless Motor Controllers.
+//  A lock-free table of the latest telemetry of every controller (Node ID)
+//  that is written by one thread and read by any number of threads.
+//
+//  The code is provided "AS IS" without any kind of guarantees or warranties.
+//  Use it at your own risk.
+//
+//  The code is free for everyone to use, modify or redistribute.
+//
+//  www.servosila.com
+//
+/////////////////////////////////////////////////////////////////////////////
+
+#ifndef SERVOSILA_TELEMETRY_STORE_H
+#define SERVOSILA_TELEMETRY_STORE_H
+
+#include "can-message.h"
+#include "canopen-decoder.h"    //extract_node_id_from_can_id()
+#include "telemetry-decoder.h"  //decode_telemetry(), node_telemetry
+#include "monotonic-clock.h"    //monotonic_ns()
+#include <stddef.h>             //size_t, offsetof()
+#include <stdint.h>             //standard integer types
+#include <string.h>             //memcpy(), memset()
+#include <atomic>               //lock-free sequence counters, C++11
+
+namespace servosila
+{
+
+//A consistent copy of the latest telemetry of one controller.
+struct node_snapshot
+{
+    node_telemetry telemetry;       //only the messages marked in 'received' hold valid data
+    uint64_t       timestamp_ns;    //monotonic_ns() time of the latest update; compare it with monotonic_ns() to detect stale telemetry
+    uint32_t       received;        //a bit per telemetry message received so far: 0x1 = 0x180, 0x2 = 0x280, 0x4 = 0x380, 0x8 = 0x480; 0 after reset()
+    uint32_t       sequence;        //number of updates so far; 0 if nothing has been received from the controller
+};
+
+//The decoder thread calls update() for every received telemetry message; the control loop, the logger
+//...and the GUI call read() from their own threads at their own rates. Every Node ID has its own slot
+//...with a sequence counter (a seqlock): the writer never waits for the readers, and a reader retries
+//...only if the slot is being written at the very moment, which takes a few dozen nanoseconds.
+//...Each slot occupies its own cache line, so readers of one controller do not slow down the others.
+//ATTENTION: there must be only one writer thread.
+class telemetry_store
+{
+public:
+    static const uint32_t MAX_NODE_ID = 127;
+
+    telemetry_store()
+    {
+        clear();
+    }
+
+    //Resets all slots. Must not be called while other threads are reading.
+    void clear()
+    {
+        memset(m_shadow, 0, sizeof(m_shadow));
+        for(uint32_t node_id=0; node_id<=MAX_NODE_ID; node_id++)
+        {
+            m_slots[node_id].sequence.store(0, std::memory_order_relaxed);
+            for(size_t i=0; i<WORD_COUNT; i++) m_slots[node_id].words[i].store(0, std::memory_order_relaxed);
+        }
+        std::atomic_thread_fence(std::memory_order_release);
+    }
+
+    //Writer side: forgets the controllers heard of so far, e.g. when the CAN network is reconnected; unlike clear(),
+    //...safe while other threads are reading: their slots are published empty, with 'received' 0, as any other update.
+    void reset()
+    {
+        for(uint32_t node_id=0; node_id<=MAX_NODE_ID; node_id++)
+        {
+            if(m_shadow[node_id].received == 0) continue;
+            memset(&(m_shadow[node_id]), 0, sizeof(m_shadow[node_id]));
+            publish(node_id, m_shadow[node_id]);
+        }
+    }
+
+    //Writer side: decodes a telemetry message and publishes the new state of the controller that sent it.
+    //...returns the COB ID of the decoded message; 0 if the message is not a telemetry message.
+    uint32_t update(const can_message& message, uint64_t timestamp_ns)
+    {
+        const uint32_t node_id = extract_node_id_from_can_id(message.can_id);
+        if(node_id > MAX_NODE_ID) return 0;
+
+        node_snapshot& shadow = m_shadow[node_id];
+        const uint32_t cob_id = decode_telemetry(message, shadow.telemetry);
+        if(cob_id == 0) return 0;
+
+        shadow.timestamp_ns = timestamp_ns;
+        shadow.received    |= 1u << ((cob_id >> 8) - 1);    //0x180->0, 0x280->1, 0x380->2, 0x480->3
+        publish(node_id, shadow);
+        return cob_id;
+    }
+
+    //same as above, the message is timestamped with monotonic_ns()
+    uint32_t update(const can_message& message)
+    {
+        return update(message, monotonic_ns());
+    }
+
+    //Writer side: the state of a controller right after update(), without going through the slot...
+    //...e.g. to pass the values of the message just decoded further down the pipeline. Not for reader threads.
+    const node_snapshot& get_latest(uint32_t node_id) const
+    {
+        return m_shadow[node_id & MAX_NODE_ID];
+    }
+
+    //Reader side: a single attempt to copy the state of a controller; never waits.
+    //...returns false if the slot was being written at the same time; the caller may try again or use its previous copy.
+    bool try_read(uint32_t node_id, node_snapshot& snapshot) const
+    {
+        if(node_id > MAX_NODE_ID) return false;
+        const slot& s = m_slots[node_id];
+
+        const uint32_t sequence_before = s.sequence.load(std::memory_order_acquire);
+        if(sequence_before & 1) return false;   //a write is in progress
+
+        uint32_t words[WORD_COUNT];
+        for(size_t i=0; i<WORD_COUNT; i++) words[i] = s.words[i].load(std::memory_order_relaxed);
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if(s.sequence.load(std::memory_order_relaxed) != sequence_before) return false;   //overwritten while being copied
+
+        memcpy(&snapshot, words, PUBLISHED_SIZE);
+        snapshot.sequence = sequence_before / 2;
+        return true;
+    }
+
+    //Reader side: copies the state of a controller, retrying while the slot is being written.
+    //...returns false only if the Node ID is out of range.
+    bool read(uint32_t node_id, node_snapshot& snapshot) const
+    {
+        if(node_id > MAX_NODE_ID) return false;
+        while(!try_read(node_id, snapshot)) {}
+        return true;
+    }
+
+    //Reader side: the number of updates of a controller so far; a cheap way to see whether there is anything new.
+    uint32_t get_sequence(uint32_t node_id) const
+    {
+        if(node_id > MAX_NODE_ID) return 0;
+        return m_slots[node_id].sequence.load(std::memory_order_acquire) / 2;
+    }
+
+private:
+    //the part of a snapshot that is published through the slot, rounded up to whole 32-bit words
+    static const size_t PUBLISHED_SIZE = offsetof(node_snapshot, sequence);
+    static const size_t WORD_COUNT = (PUBLISHED_SIZE + sizeof(uint32_t) - 1) / sizeof(uint32_t);
+
+    struct alignas(64) slot
+    {
+        std::atomic<uint32_t> sequence;             //odd while the slot is being written
+        std::atomic<uint32_t> words[WORD_COUNT];    //the snapshot, copied word by word
+    };
+
+    slot          m_slots[MAX_NODE_ID + 1];
+    node_snapshot m_shadow[MAX_NODE_ID + 1];    //the writer's own copy; incoming messages are decoded into it
+
+    void publish(uint32_t node_id, const node_snapshot& shadow)
+    {
+        slot& s = m_slots[node_id];
+        uint32_t words[WORD_COUNT];
+        words[WORD_COUNT - 1] = 0;
+        memcpy(words, &shadow, PUBLISHED_SIZE);
+
+        const uint32_t sequence = s.sequence.load(std::memory_order_relaxed);
+        s.sequence.store(sequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        for(size_t i=0; i<WORD_COUNT; i++) s.words[i].store(words[i], std::memory_order_relaxed);
+        s.sequence.store(sequence + 2, std::memory_order_release);
+    }
+
+    telemetry_store(const telemetry_store&);            //non-copyable
+    telemetry_store& operator=(const telemetry_store&);
+};
+
+} //namespace servosila
+
+#endif // SERVOSILA_TELEMETRY_STORE_H
@@ -2,10 +2,12 @@
 //
 //  This sample source code comes with Servosila SC-25C Brushless Motor Controllers.
 //
-//  This example sends an Electronic Speed Control (ESC) command in a loop to a controller.
+//  This example sends Electronic Speed Control (ESC) commands in a loop to several controllers.
 //      OS: Linux,
 //      Interface: SLCAN text protocol via virtual servial port.
 //
+//  Usage: slcan-esc-command [serial device, /dev/ttyACM0 by default; e.g. the pseudo-terminal of controller-simulator]
+//
 //  The code is provided "AS IS" without any kind of guarantees or warranties.
 //  Use it at your own risk.
 //
@@ -15,63 +17,82 @@
 //
 /////////////////////////////////////////////////////////////////////////////////////////////////
 
-#include "../servosila-common/slcan-encoder.h"  //SLCAN encoder function
-#include <fstream>                              //file stream output
-#include <string.h>                             //memcpy(), memset()
-#include <stdint.h>                             //standard integer types
-#include <chrono>                               //sleep(), C++11
-#include <thread>                               //sleep(), C++11
+#include "../servosila-common/slcan-transport.h"        //SLCAN over a virtual serial port
+#include "../servosila-common/event-loop.h"             //epoll-based main loop
+#include "../servosila-common/command-scheduler.h"      //per-controller command scheduling
+#include "../servosila-common/monotonic-clock.h"        //monotonic_ns()
+#include "../servosila-common/realtime-loop.h"          //SCHED_FIFO cycle with absolute deadlines
+#include <iostream>                                     //console output
+#include <stdint.h>                                     //standard integer types
+#include <chrono>                                       //timer periods, C++11
 
-int main()
-{    
-    //a standard C++ stream object for writing to a virtual serial port on Linux
-    std::ofstream device;
+int main(int argc, char* argv[])
+{
+    const char* device_name = (argc > 1) ? argv[1] : "/dev/ttyACM0";
 
     //opening virtual serial port...
     //...check that the file name is correct...
-    device.open ("/dev/ttyACM0");           //if this fails on Linux: sudo usermod -G dialout $USER
-
-    //an SLCAN message buffer: an array of chars
-    char message[27];
-    //a CAN Payload array (8bytes)
-    uint8_t payload[8];
+    servosila::slcan_transport transport;
+    if(!transport.startup(device_name)) return 1;    //if this fails on Linux: sudo usermod -G dialout $USER
 
-    const uint32_t NODE_ID      = 5;        //this is a unique Node ID of the device. Change this to match your device.
-    const uint32_t COB_ID       = 0x200;    //this value comes from Servosila Device Reference document, section related to "Electronic Speed Control" command
-    const uint8_t  COMMAND_CODE = 0x20;     //this value comes from Servosila Device Reference document, section related to "Electronic Speed Control" command
-    const float    SPEED        = 100.0;    //Hz (electrical), this is a target speed that needs to be sent to the controller. A constant in this example, but normally this is dynamically computed.
+    const uint32_t NODE_IDS[]   = { 5 };    //these are unique Node IDs of the devices. Change this to match your devices; add as many as there are on the CAN network.
+    const float    SPEED        = 100.0;    //Hz (electrical), this is a target speed that needs to be sent to the controllers. A constant in this example, but normally this is dynamically computed.
+    const bool     IS_REALTIME_ENABLED = false;     //a fixed 1ms cycle with SCHED_FIFO priority instead of sleeping in epoll (see realtime-loop.h)
 
-    //Main Loop
-    for(size_t i=0; i<100; i++)     //this should normally be a while(true) loop
+    //The scheduler keeps the latest command of every controller and sends it out at the controller's own rate...
+    //...200ms=5Hz refresh; do not send commands too often as the controller wastes CPU cycles on this, it could otherwise use the cycles to better run the motor.
+    //...a changed command goes out early, but not sooner than 20ms after the previous one.
+    servosila::command_scheduler scheduler;
+    const uint64_t now_ns = servosila::monotonic_ns();
+    for(size_t i=0; i<sizeof(NODE_IDS)/sizeof(NODE_IDS[0]); i++)
     {
-        //zero out all 8 bytes in the payload before filling out with new data
-        memset(&payload, 0, sizeof(payload));
+        scheduler.add_node(NODE_IDS[i], 200000000ull, 20000000ull, now_ns);
+        scheduler.set_command(servosila::make_esc_command(NODE_IDS[i], SPEED));
+    }
 
-        //setting Command Code in Payload
-        payload[0] = COMMAND_CODE;          //the very first byte in payload of a command message is the command code.
+    //Main Loop: an event-driven loop that sleeps in epoll until there is something to do
+    servosila::event_loop main_loop;
 
-        //setting Speed parameter in Payload
-        // That the parameter is a FLOAT32 with position 4 comes from Servosila Device Reference document, section related to "Electronic Speed Control" command.
-        memcpy(&(payload[4]), &(SPEED), sizeof(SPEED));
+    //the scheduler is polled every 10ms; the commands that are due are batched and written with a single write()...
+    //...the SLCAN text of every command is encoded once and then only patched as the commands change (see slcan-command-builder.h).
+    main_loop.add_timer(std::chrono::milliseconds(10), [&transport, &scheduler]()
+    {
+        //TODO: update the commands here with scheduler.set_command() as the targets change
 
-        //encoding an SLCAN text message
-        //...the routine is implemented in slcan-encoder.h
-        //...the inputs are Node ID, COB ID, and Payload.
-        const size_t message_size = servosila::slcan_encode_11bit(NODE_ID+COB_ID, payload, 8, message);
+        servosila::can_message messages[16];
+        const size_t nmessages = scheduler.collect(servosila::monotonic_ns(), messages, 16);
 
-        //writing the SLCAN text message to the virtual serial port
-        device.write(&(message[0]), message_size);
-        device.flush();                     //this is needed before the sleep() function
+        //a failed write (e.g. the adapter has been unplugged) is not retried; the commands are repeated on their next refresh
+        if(nmessages > 0) transport.send_many(messages, nmessages);
+    });
 
-        //TODO: read out and process telemetry here (see a different example)
+    //TODO: read out and process telemetry here (see a different example)
 
-        //this is just a portable way to sleep() in the main loop...
-        //...this method requires C++11
-        std::this_thread::sleep_for(std::chrono::milliseconds(200));    //200ms=5Hz; sending the command 5 times a second; do not send commands too often as the controller wastes CPU cycles on this, it could otherwise use the cycles to better run the motor.
+    //this example stops after 20 seconds; normally the loop runs until the application exits
+    main_loop.add_timer(std::chrono::seconds(20), [&main_loop]()
+    {
+        main_loop.stop();
+    });
+
+    //this call returns once main_loop.stop() is called from one of the handlers
+    if(IS_REALTIME_ENABLED)
+    {
+        //the commands go out on the 1ms grid; the settings need privileges, without them the loop still keeps its cycle
+        servosila::realtime_loop realtime;
+        servosila::realtime_config config(1000000ull);     //1ms
+        config.priority = 80;
+        config.cpu      = 1;
+        if(!realtime.setup(config)) std::cerr<<"Real-time settings have not been applied in full"<<std::endl;
+        servosila::run_event_loop(realtime, main_loop);
+        realtime.dump(std::cout);   //the wake-up jitter and the cycle overruns of the session
+    }
+    else
+    {
+        main_loop.run();
     }
 
     //closing the virtual serial port
-    device.close();
+    transport.shutdown();
 
     return 0;
 }
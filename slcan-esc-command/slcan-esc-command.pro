@@ -2,6 +2,7 @@ TEMPLATE = app
 CONFIG += console
 CONFIG -= app_bundle
 CONFIG -= qt
+CONFIG += thread
 
 CONFIG += c++11
 
@@ -9,4 +10,17 @@ SOURCES += \
     main.cpp
 
 HEADERS += \
-    ../servosila-common/slcan-encoder.h
+    ../servosila-common/can-id-filter.h \
+    ../servosila-common/can-message.h \
+    ../servosila-common/command-scheduler.h \
+    ../servosila-common/commands.h \
+    ../servosila-common/event-loop.h \
+    ../servosila-common/hex-codec.h \
+    ../servosila-common/instrumentation.h \
+    ../servosila-common/monotonic-clock.h \
+    ../servosila-common/realtime-loop.h \
+    ../servosila-common/slcan-buffer-decoder.h \
+    ../servosila-common/slcan-command-builder.h \
+    ../servosila-common/slcan-message-encoder.h \
+    ../servosila-common/serial-port.h \
+    ../servosila-common/slcan-transport.h
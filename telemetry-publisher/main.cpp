@@ -0,0 +1,135 @@
+///////////////////////////////////////////////////////////////////////////////////////////////
+//
+//  This sample source code comes with Servosila SC-25C Brushless Motor Controllers.
+//
+//  This example is a daemon that owns the CAN interface and shares the telemetry with any number
+//  of local processes (a control loop, a logger, a dashboard) through POSIX shared memory.
+//  The processes submit commands through the same shared memory; the daemon sends them out.
+//      OS: Linux,
+//      Interface: Linux SocketCAN API
+//
+//  Usage: telemetry-publisher [network name, can0 by default]
+//      the readers attach with servosila::shared_telemetry_subscriber (see telemetry-subscriber example).
+//      Ctrl+C stops the daemon and removes the shared memory object.
+//
+//  The code is provided "AS IS" without any kind of guarantees or warranties.
+//  Use it at your own risk.
+//
+//  The code is free for everyone to use, modify or redistribute.
+//
+//  www.servosila.com
+//
+///////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "../servosila-common/socketcan.h"          //SocketCAN encapsulation
+#include "../servosila-common/event-loop.h"         //epoll-based main loop
+#include "../servosila-common/shared-telemetry.h"   //shared memory publisher
+#include <iostream>                                 //console output
+#include <stdint.h>                                 //standard integer types
+#include <signal.h>                                 //sigprocmask()
+#include <sys/signalfd.h>                           //signalfd()
+#include <unistd.h>                                 //read(), close()
+#include <chrono>                                   //timer periods, C++11
+
+//sends out the commands submitted by the readers; the commands of every reader in the order of submission
+void send_commands(servosila::socketcan& canbus, servosila::shared_telemetry_publisher& publisher)
+{
+    servosila::can_message messages[64];
+    size_t nmessages = 0;
+    while(nmessages < 64 && publisher.try_pop_command(messages[nmessages])) nmessages++;
+    if(nmessages > 0) canbus.send_many(messages, nmessages);
+}
+
+int main(int argc, char* argv[])
+{
+    const char* network_name = (argc > 1) ? argv[1] : "can0";   //check the network name, it could be different in your system
+
+    //An object that encapsulates Linux SocketCAN API
+    servosila::socketcan canbus;
+    if(!canbus.startup(network_name))
+    {
+        std::cerr<<"Cannot open CAN network "<<network_name<<std::endl;
+        return 1;
+    }
+    //the frames are stamped by the kernel as they arrive, not when the daemon gets around to reading them
+    canbus.set_timestamping(servosila::TIMESTAMP_KERNEL);
+
+    //creating the shared memory object; all frames received from now on are published into it
+    servosila::shared_telemetry_publisher publisher;
+    if(!publisher.open())
+    {
+        std::cerr<<"Cannot create shared memory object "<<servosila::SHARED_TELEMETRY_NAME<<"; is another daemon running?"<<std::endl;
+        canbus.shutdown();
+        return 1;
+    }
+
+    //SIGINT and SIGTERM are delivered through a descriptor, so that the daemon stops from the main loop and cleans up
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    sigprocmask(SIG_BLOCK, &signals, nullptr);
+    const int signal_fd = ::signalfd(-1, &signals, SFD_NONBLOCK | SFD_CLOEXEC);
+
+    //Main Loop: an event-driven loop that sleeps in epoll until there is something to do
+    servosila::event_loop main_loop;
+
+    //publishing every frame as soon as it arrives; the telemetry is decoded here once for all readers
+    uint64_t frame_count = 0;
+    main_loop.add_reader(canbus.get_socket(), [&canbus, &publisher, &frame_count]()
+    {
+        servosila::can_message messages[64];
+        uint64_t timestamps_ns[64];
+        while(true)
+        {
+            const size_t nmessages = canbus.receive_many(messages, timestamps_ns, 64);
+            for(size_t i=0; i<nmessages; i++)
+            {
+                publisher.publish(messages[i], timestamps_ns[i], canbus.get_timestamp_source());
+            }
+            frame_count += nmessages;
+            if(nmessages < 64) break;   //the socket has been drained
+        }
+        //a reader waiting for telemetry to react to usually submits its command right after it
+        send_commands(canbus, publisher);
+    });
+
+    //the readers do not wake the daemon up, so the command queue is also checked every millisecond
+    main_loop.add_timer(std::chrono::milliseconds(1), [&canbus, &publisher]()
+    {
+        send_commands(canbus, publisher);
+    });
+
+    //the readers take the daemon for dead if the heartbeats stop (see SHARED_TELEMETRY_TIMEOUT_NS)
+    main_loop.add_timer(std::chrono::milliseconds(100), [&publisher]()
+    {
+        publisher.heartbeat();
+    });
+
+    //a status line every 10 seconds
+    main_loop.add_timer(std::chrono::seconds(10), [&frame_count]()
+    {
+        std::cout<<"Frames published: "<<frame_count<<'\n'<<std::flush;
+    });
+
+    if(signal_fd >= 0)
+    {
+        main_loop.add_reader(signal_fd, [signal_fd, &main_loop]()
+        {
+            struct signalfd_siginfo info;
+            if(::read(signal_fd, &info, sizeof(info)) == sizeof(info)) main_loop.stop();
+        });
+    }
+
+    std::cout<<"Publishing "<<network_name<<" to "<<servosila::SHARED_TELEMETRY_NAME<<'\n'<<std::flush;
+
+    //this call returns once main_loop.stop() is called from one of the handlers
+    main_loop.run();
+
+    //the readers see the telemetry go offline; the shared memory object is removed
+    publisher.close();
+    if(signal_fd >= 0) ::close(signal_fd);
+    canbus.shutdown();
+
+    return 0;
+}
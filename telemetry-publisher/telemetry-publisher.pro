@@ -0,0 +1,22 @@
+TEMPLATE = app
+CONFIG += console c++11
+CONFIG -= app_bundle
+CONFIG -= qt
+
+LIBS += -lrt
+
+SOURCES += \
+        main.cpp
+
+HEADERS += \
+    ../servosila-common/canopen-decoder.h \
+    ../servosila-common/can-id-filter.h \
+    ../servosila-common/can-message.h \
+    ../servosila-common/event-loop.h \
+    ../servosila-common/float16-batch.h \
+    ../servosila-common/frame-logger.h \
+    ../servosila-common/monotonic-clock.h \
+    ../servosila-common/shared-telemetry.h \
+    ../servosila-common/socketcan.h \
+    ../servosila-common/telemetry-decoder.h \
+    ../servosila-common/telemetry-store.h
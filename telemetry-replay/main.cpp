@@ -0,0 +1,194 @@
+///////////////////////////////////////////////////////////////////////////////////////////////
+//
+//  This sample source code comes with Servosila SC-25C Brushless Motor Controllers.
+//
+//  This example replays recorded CAN traffic through the telemetry decoders without hardware
+//  and reports the decoding throughput.
+//      OS: Linux,
+//      Input: a binary frame log (see frame-logger.h) or a raw SLCAN text capture of a serial port.
+//
+//  Usage: telemetry-replay <file> [--realtime] [--repeat N]
+//      --realtime  replays a binary frame log with the original timing instead of at full speed;
+//                  the pauses between recording sessions and over 1 second are skipped
+//      --repeat N  replays the file N times, e.g. to get a stable throughput figure from a short capture
+//
+//  The code is provided "AS IS" without any kind of guarantees or warranties.
+//  Use it at your own risk.
+//
+//  The code is free for everyone to use, modify or redistribute.
+//
+//  www.servosila.com
+//
+///////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "../servosila-common/mapped-file.h"            //memory-mapped input file
+#include "../servosila-common/frame-log-reader.h"       //binary frame logs
+#include "../servosila-common/slcan-buffer-decoder.h"   //SLCAN decoder class
+#include "../servosila-common/telemetry-store.h"        //telemetry decoding, the same as in the telemetry examples
+#include "../servosila-common/monotonic-clock.h"        //monotonic_ns()
+#include <iostream>                                     //console output
+#include <string.h>                                     //strcmp()
+#include <stdlib.h>                                     //atoi()
+#include <stdint.h>                                     //standard integer types
+#include <time.h>                                       //clock_nanosleep()
+#include <errno.h>                                      //EINTR
+
+//The same decoding path as in canbus-telemetry and slcan-telemetry
+servosila::telemetry_store telemetry;
+
+//replay statistics
+uint64_t frame_count     = 0;   //frames handed over to the decoders
+uint64_t telemetry_count = 0;   //frames decoded as telemetry messages
+
+void process_message(const servosila::can_message& message, uint64_t timestamp_ns)
+{
+    frame_count++;
+    if(telemetry.update(message, timestamp_ns) != 0) telemetry_count++;
+}
+
+//sleeps until a moment of CLOCK_MONOTONIC time
+void sleep_until_ns(uint64_t deadline_ns)
+{
+    struct timespec deadline;
+    deadline.tv_sec  = static_cast<time_t>(deadline_ns / 1000000000ull);
+    deadline.tv_nsec = static_cast<long>  (deadline_ns % 1000000000ull);
+    while(::clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, nullptr) == EINTR) {}
+}
+
+//Replays a binary frame log; the original timestamps are kept, so that the telemetry table looks the same as during the recording...
+//...in real time, the replay clock is rebased at the start of every recording session and wherever the timestamps
+//...jump back or leap forward: the time between two sessions or across a reboot is not slept through.
+//...returns the number of recording sessions in the log.
+uint64_t replay_frame_log(const servosila::frame_log_reader& reader, bool is_realtime)
+{
+    const uint64_t MAX_GAP_NS = 1000000000ull;  //1s; a longer pause on the bus is replayed as a short one
+
+    const size_t count = reader.get_count();
+    if(count == 0) return 0;
+
+    //the record time 'base_timestamp_ns' is replayed at the monotonic_ns() time 'base_ns'
+    uint64_t base_timestamp_ns = reader.get_record(0).timestamp_ns;
+    uint64_t base_ns = servosila::monotonic_ns();
+    uint64_t previous_timestamp_ns = base_timestamp_ns;
+    uint64_t session_count = 0;
+
+    servosila::can_message message;
+    for(size_t i=0; i<count; i++)
+    {
+        const servosila::frame_log_record& record = reader.get_record(i);
+        if(servosila::frame_log_reader::is_session(record))
+        {   //a new session: its frames are on a time line of their own
+            session_count++;
+            base_timestamp_ns = previous_timestamp_ns = record.timestamp_ns;
+            base_ns = servosila::monotonic_ns();
+            continue;
+        }
+        if(is_realtime)
+        {
+            if(record.timestamp_ns < previous_timestamp_ns || record.timestamp_ns - previous_timestamp_ns > MAX_GAP_NS)
+            {   //the frame is replayed right away, and the following ones relative to it
+                base_timestamp_ns = record.timestamp_ns;
+                base_ns = servosila::monotonic_ns();
+            }
+            //waiting for the moment the frame originally arrived, relative to the base
+            sleep_until_ns(base_ns + (record.timestamp_ns - base_timestamp_ns));
+        }
+        previous_timestamp_ns = record.timestamp_ns;
+        servosila::frame_log_reader::to_can_message(record, message);
+        process_message(message, record.timestamp_ns);
+    }
+    return session_count;
+}
+
+//Replays a raw SLCAN capture in blocks of the same size slcan-telemetry reads from the serial port,
+//...so that frames split between two blocks are decoded the same way as with real hardware.
+//...SLCAN text carries no arrival times, so it is always replayed at full speed.
+void replay_slcan(const char* data, size_t size, servosila::slcan_buffer_decoder& decoder)
+{
+    const size_t BLOCK_SIZE = 4096;
+    const uint64_t timestamp_ns = servosila::monotonic_ns();
+    for(size_t offset=0; offset<size; offset+=BLOCK_SIZE)
+    {
+        const size_t block_size = (size - offset < BLOCK_SIZE) ? (size - offset) : BLOCK_SIZE;
+        decoder.process_buffer(&(data[offset]), block_size, [timestamp_ns](const servosila::can_message& message)
+        {
+            process_message(message, timestamp_ns);
+        });
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    //parsing the command line
+    const char* file_name = nullptr;
+    bool is_realtime = false;
+    int repeat_count = 1;
+    for(int i=1; i<argc; i++)
+    {
+        if(strcmp(argv[i], "--realtime") == 0) is_realtime = true;
+        else if(strcmp(argv[i], "--repeat") == 0 && i + 1 < argc) repeat_count = atoi(argv[++i]);
+        else file_name = argv[i];
+    }
+    if(file_name == nullptr || repeat_count < 1)
+    {
+        std::cerr<<"Usage: telemetry-replay <file> [--realtime] [--repeat N]"<<std::endl;
+        return 1;
+    }
+
+    //mapping the whole capture into memory; the decoders read it in place
+    servosila::mapped_file file;
+    if(!file.open(file_name))
+    {
+        std::cerr<<"Cannot open "<<file_name<<std::endl;
+        return 1;
+    }
+
+    //telling a binary frame log from SLCAN text by the magic in the header
+    servosila::frame_log_reader reader;
+    const bool is_frame_log = servosila::frame_log_reader::is_frame_log(file.data(), file.size());
+    if(is_frame_log && !reader.attach(file.data(), file.size()))
+    {
+        std::cerr<<"Unsupported frame log version in "<<file_name<<std::endl;
+        return 1;
+    }
+    if(!is_frame_log && is_realtime)
+    {
+        std::cerr<<"SLCAN text carries no arrival times; replaying at full speed"<<std::endl;
+    }
+
+    //the same SLCAN decoder set-up as in slcan-telemetry
+    servosila::slcan_buffer_decoder decoder;
+
+    //the sessions are those of the file, not of the replay: every pass has to find the same number of them
+    uint64_t session_count = 0;
+    const uint64_t start_ns = servosila::monotonic_ns();
+    for(int i=0; i<repeat_count; i++)
+    {
+        if(is_frame_log)
+        {
+            const uint64_t nsessions = replay_frame_log(reader, is_realtime);
+            if(i == 0) session_count = nsessions;
+            else if(nsessions != session_count)
+            {
+                std::cerr<<"Pass "<<i + 1<<" found "<<nsessions<<" sessions instead of "<<session_count<<std::endl;
+                return 1;
+            }
+        }
+        else replay_slcan(file.data(), file.size(), decoder);
+    }
+    const uint64_t elapsed_ns = servosila::monotonic_ns() - start_ns;
+
+    //reporting the results
+    const double elapsed_s = static_cast<double>(elapsed_ns) / 1e9;
+    std::cout<<"Input: "<<(is_frame_log ? "binary frame log" : "SLCAN text")<<", "<<file.size()<<" bytes x "<<repeat_count<<'\n';
+    if(is_frame_log) std::cout<<"Sessions: "<<session_count<<'\n';
+    std::cout<<"Frames: "<<frame_count<<", telemetry messages: "<<telemetry_count<<", malformed SLCAN frames: "<<decoder.get_error_count()<<'\n';
+    std::cout<<"Time: "<<elapsed_s<<" s"<<'\n';
+    if(elapsed_ns > 0)
+    {
+        std::cout<<"Throughput: "<<static_cast<double>(frame_count) / elapsed_s<<" frames/s, "
+                 <<static_cast<double>(elapsed_ns) / static_cast<double>(frame_count ? frame_count : 1)<<" ns/frame"<<'\n';
+    }
+
+    return 0;
+}
@@ -0,0 +1,20 @@
+TEMPLATE = app
+CONFIG += console c++11
+CONFIG -= app_bundle
+CONFIG -= qt
+
+SOURCES += \
+        main.cpp
+
+HEADERS += \
+    ../servosila-common/canopen-decoder.h \
+    ../servosila-common/can-id-filter.h \
+    ../servosila-common/can-message.h \
+    ../servosila-common/frame-log-reader.h \
+    ../servosila-common/frame-logger.h \
+    ../servosila-common/mapped-file.h \
+    ../servosila-common/monotonic-clock.h \
+    ../servosila-common/slcan-buffer-decoder.h \
+    ../servosila-common/float16-batch.h \
+    ../servosila-common/telemetry-decoder.h \
+    ../servosila-common/telemetry-store.h
@@ -0,0 +1,84 @@
+///////////////////////////////////////////////////////////////////////////////////////////////
+//
+//  This sample source code comes with Servosila SC-25C Brushless Motor Controllers.
+//
+//  This example reads the telemetry shared by the telemetry-publisher daemon. Any number of
+//  copies of it (or of other programs that do the same) may run at the same time.
+//      OS: Linux,
+//      Interface: POSIX shared memory (see shared-telemetry.h)
+//
+//  Usage: telemetry-subscriber [--reset NODE_ID]
+//      --reset NODE_ID  submits a RESET command to a controller through the daemon, then keeps reading
+//
+//  The code is provided "AS IS" without any kind of guarantees or warranties.
+//  Use it at your own risk.
+//
+//  The code is free for everyone to use, modify or redistribute.
+//
+//  www.servosila.com
+//
+///////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "../servosila-common/shared-telemetry.h"   //shared memory subscriber
+#include "../servosila-common/commands.h"           //make_reset_command()
+#include <iostream>                                 //console output
+#include <string.h>                                 //strcmp()
+#include <stdlib.h>                                 //atoi()
+#include <stdint.h>                                 //standard integer types
+#include <thread>                                   //sleep_for(), C++11
+#include <chrono>                                   //polling period, C++11
+
+int main(int argc, char* argv[])
+{
+    //attaching to the daemon's shared memory object
+    servosila::shared_telemetry_subscriber subscriber;
+    if(!subscriber.open())
+    {
+        std::cerr<<"The telemetry-publisher daemon is not running"<<std::endl;
+        return 1;
+    }
+
+    //commands go to the CAN network through the daemon, which owns the CAN interface
+    if(argc > 2 && strcmp(argv[1], "--reset") == 0)
+    {
+        const uint32_t node_id = static_cast<uint32_t>(atoi(argv[2]));
+        if(!subscriber.submit_command(servosila::make_reset_command(node_id)))
+        {
+            std::cerr<<"The command has not been queued: the queue is full, or too many readers submit commands"<<std::endl;
+        }
+    }
+
+    //the telemetry sequence number of every controller at the previous printout
+    uint32_t sequences[servosila::telemetry_store::MAX_NODE_ID + 1] = { 0 };
+    uint64_t frame_count = 0;
+
+    while(subscriber.is_online())
+    {
+        //reading every frame received since the previous pass, e.g. for logging or for filtering of the speed...
+        //...the frames are copied out of the ring buffer in place, without a system call.
+        servosila::frame_log_record records[256];
+        size_t nrecords = 0;
+        while((nrecords = subscriber.read_frames(records, 256)) > 0) frame_count += nrecords;
+
+        //printing out the latest state of the controllers that have sent telemetry since the previous pass
+        const servosila::telemetry_store& telemetry = subscriber.get_telemetry();
+        for(uint32_t node_id=1; node_id<=servosila::telemetry_store::MAX_NODE_ID; node_id++)
+        {
+            const uint32_t sequence = telemetry.get_sequence(node_id);
+            if(sequence == sequences[node_id]) continue;
+            sequences[node_id] = sequence;
+
+            servosila::node_snapshot snapshot;
+            telemetry.read(node_id, snapshot);
+            if(!(snapshot.received & 0x1)) continue;   //no 0x180 yet
+            const servosila::telemetry_180& pdo_180 = snapshot.telemetry.pdo_180;
+            std::cout<<"Node ID: "<<node_id<<" Fault Bits: "<<pdo_180.fault_bits<<" "<<pdo_180.Udc<<" V DC Speed: "<<pdo_180.speed<<" Hz"<<'\n';
+        }
+        std::cout<<"Frames: "<<frame_count<<" lost: "<<subscriber.get_lost_count()<<'\n'<<std::flush;
+
+        std::this_thread::sleep_for(std::chrono::seconds(1));
+    }
+
+    std::cout<<"The daemon has stopped"<<std::endl;
+    return 0;
+}